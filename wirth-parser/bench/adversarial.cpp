@@ -0,0 +1,286 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "earley.h"
+#include "events.h"
+#include "json.h"
+#include "parser.h"
+#include "structural.h"
+#include "tokens.h"
+
+#include "backtrack_recognizer.h"
+#include "csv_recognizer.h"
+#include "expr_recognizer.h"
+#include "json_recognizer.h"
+
+/*
+A search for inputs that make a parser do the most work per input byte. Work
+is the number of steps counted by the core parsers in parse_steps. For each of
+a series of growing lengths, a hill climb mutates the worst input found so far,
+starting from a seed sentence, and keeps a mutant that takes at least as many
+steps. The worst input of each length seeds the next length.
+
+The worst step counts are then fitted against length both as a power law and as
+an exponential. The growth is reported as exponential if the exponential fits
+better or if an input went past the step limit, and then the exit status is 1
+so the tool can fail a build.
+*/
+
+namespace {
+
+struct Entry
+{
+    std::string_view name;
+    void (*parse)(std::string_view);
+    std::string_view seed;
+};
+
+Parse_handler no_events;
+
+std::vector<Entry> const entries{
+    {"syntax", [](std::string_view x){ syntax(x); }, "a = b [\"c\"\"d\"] | {(e | f) g}.\n"},
+    {"lexed_syntax", [](std::string_view x){ lexed_syntax(x); }, "a = b [\"c\"\"d\"] | {(e | f) g}.\n"},
+    {"indexed_syntax", [](std::string_view x){ indexed_syntax(x); }, "a = b [\"c\"\"d\"] | {(e | f) g}.\n"},
+    {"earley_syntax", [](std::string_view x){ earley_syntax(x); }, "a = b [\"c\"\"d\"] | {(e | f) g}.\n"},
+    {"events", [](std::string_view x){ parse_events(x, no_events); }, "a = b [\"c\"\"d\"] | {(e | f) g}.\n"},
+    {"json", [](std::string_view x){ json_grammar::json(x); }, "{\"a\": [1.5e3, true, null], \"b\\n\": {}}"},
+    {"csv", [](std::string_view x){ csv_grammar::file(x); }, "a,\"b\"\"c\",d\n1,,\"x,y\"\n"},
+    {"expr", [](std::string_view x){ expr_grammar::program(x); }, "x = f(1, -y) * (2 + z) <= 3 && !w;\n"},
+    {"backtrack", [](std::string_view x){ backtrack_grammar::a(x); }, "((zy)x)y"},
+};
+
+struct Search_options
+{
+    std::string_view entry = "syntax";
+    std::size_t max_length = 256;
+    std::size_t evaluations = 2000;
+    std::uint64_t max_steps = 10'000'000;
+    std::uint64_t seed = 1;
+};
+
+class Search
+{
+public:
+
+    Search(Entry const& entry, Search_options const& options)
+        : entry_{entry}, budget_{options.max_steps}, random_{options.seed}, alphabet_{entry.seed}
+    {
+        std::ranges::sort(alphabet_);
+        auto const [first, last] = std::ranges::unique(alphabet_);
+        alphabet_.erase(first, last);
+    }
+
+    // Returns the input of the given length that takes the most steps found
+    // by evaluations mutations of start, which must have that length. Stops
+    // at the first input that goes past the step budget.
+    std::pair<std::string, std::uint64_t> climb(std::string start, std::size_t evaluations)
+    {
+        auto best = std::pair{start, steps(start)};
+        for (std::size_t i = 0; i != evaluations && best.second <= budget_.steps; ++i) {
+            auto candidate = best.first;
+            for (auto n = 1 + pick(4); n-- != 0; ) mutate(candidate);
+            if (auto const count = steps(candidate); count >= best.second) {
+                best = {std::move(candidate), count};
+            }
+        }
+        return best;
+    }
+
+private:
+
+    // Returns the number of steps it takes to parse the input, or one more
+    // than the budget if the parse was abandoned.
+    std::uint64_t steps(std::string_view input) const
+    {
+        auto const parse = [this](std::string_view x){ entry_.parse(x); return Parsed_t<Unit>{}; };
+        return bounded_parse(parse, input, budget_).steps;
+    }
+
+    std::size_t pick(std::size_t n) { return std::uniform_int_distribution<std::size_t>{0, n - 1}(random_); }
+
+    char letter() { return alphabet_[pick(alphabet_.size())]; }
+
+    // Changes the input without changing its length.
+    void mutate(std::string& input)
+    {
+        auto const size = input.size();
+        auto const at = pick(size);
+        switch (pick(5)) {
+        case 0:
+            input[at] = letter();
+            break;
+        case 1:
+            input.insert(at, 1, letter());
+            input.pop_back();
+            break;
+        case 2:
+            input.erase(at, 1);
+            input.push_back(letter());
+            break;
+        case 3: {
+            // Copies a chunk of the input over another, to repeat structure.
+            auto const from = pick(size);
+            auto const count = 1 + pick(std::min<std::size_t>(16, size - std::max(at, from)));
+            input.replace(at, count, input.substr(from, count));
+            break;
+        }
+        default: {
+            // Splices in a chunk of the seed.
+            auto const seed = entry_.seed;
+            auto const from = pick(seed.size());
+            auto const count = 1 + pick(std::min(seed.size() - from, size - at));
+            input.replace(at, count, seed.substr(from, count));
+            break;
+        }
+        }
+    }
+
+    Entry const& entry_;
+    Parse_budget budget_;
+    std::mt19937_64 random_;
+    std::string alphabet_;
+};
+
+// Returns the input repeated or cut to the given length.
+std::string resized(std::string_view input, std::size_t length)
+{
+    std::string ret;
+    while (ret.size() < length) ret += input;
+    ret.resize(length);
+    return ret;
+}
+
+// Returns the slope and the coefficient of determination of the least squares
+// line through the points.
+std::pair<double, double> fit(std::vector<std::pair<double, double>> const& points)
+{
+    auto const n = static_cast<double>(points.size());
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+    for (auto const& [x, y] : points) {
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        syy += y * y;
+    }
+    auto const vx = n * sxx - sx * sx;
+    auto const vy = n * syy - sy * sy;
+    auto const cov = n * sxy - sx * sy;
+    if (vx == 0) return {0, 0};
+    return {cov / vx, vy == 0 ? 1 : cov * cov / (vx * vy)};
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Search_options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{argv[i]};
+        if (arg == "--entry" && i + 1 != argc) {
+            options.entry = argv[++i];
+        } else if (arg == "--max-length" && i + 1 != argc) {
+            options.max_length = std::max<std::size_t>(8, std::stoull(argv[++i]));
+        } else if (arg == "--evaluations" && i + 1 != argc) {
+            options.evaluations = std::stoull(argv[++i]);
+        } else if (arg == "--max-steps" && i + 1 != argc) {
+            options.max_steps = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && i + 1 != argc) {
+            options.seed = std::stoull(argv[++i]);
+        } else {
+            std::cerr << "Usage: wirth-parser-adversarial [--entry <name>] [--max-length <bytes>] [--evaluations <n>] [--max-steps <n>] [--seed <n>]\n"
+                      << "Entries:";
+            for (auto const& entry : entries) std::cerr << ' ' << entry.name;
+            std::cerr << '\n';
+            return 2;
+        }
+    }
+
+    auto const entry = std::ranges::find(entries, options.entry, &Entry::name);
+    if (entry == entries.end()) {
+        std::cerr << "Error: Unknown entry point " << options.entry << ".\n";
+        return 2;
+    }
+
+    // A first run builds whatever the entry point initializes on first use,
+    // so that its steps are not counted against the first input.
+    entry->parse(entry->seed);
+
+    // Lengths grow by half each time, which is slow enough for the worst input
+    // of one length to be a good start for the next. The search stops early
+    // once an input reaches max_steps, as a parser that is exponential would
+    // not finish at the next length.
+    Search search{*entry, options};
+    std::vector<std::pair<std::string, std::uint64_t>> worst;
+    for (std::size_t length = 8; length <= options.max_length; length += length / 2) {
+        auto const start = worst.empty() ? resized(entry->seed, length) : resized(worst.back().first, length);
+        worst.push_back(search.climb(start, options.evaluations));
+        if (worst.back().second > options.max_steps) break;
+    }
+    auto const limited = worst.back().second > options.max_steps;
+
+    // Only the inputs that finished are fitted.
+    std::vector<std::pair<double, double>> power, exponential;
+    for (auto const& [input, count] : worst) {
+        if (count > options.max_steps) continue;
+        auto const length = static_cast<double>(input.size());
+        auto const work = std::log(static_cast<double>(std::max<std::uint64_t>(count, 1)));
+        power.emplace_back(std::log(length), work);
+        exponential.emplace_back(length, work);
+    }
+    auto const [degree, power_r2] = fit(power);
+    auto const [rate, exponential_r2] = fit(exponential);
+    auto const is_exponential = limited || (power.size() >= 3 && exponential_r2 > power_r2);
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "{\n  \"entry\": " << json_string(entry->name)
+              << ",\n  \"evaluations\": " << options.evaluations
+              << ",\n  \"seed\": " << options.seed
+              << ",\n  \"worst\": [";
+    for (auto const& [input, count] : worst) {
+        std::cout << (&input == &worst.front().first ? "\n" : ",\n")
+                  << "    {\"length\": " << input.size() << ", \"steps\": " << count
+                  << ", \"steps_per_byte\": " << static_cast<double>(count) / static_cast<double>(input.size())
+                  << ", \"limited\": " << (count > options.max_steps ? "true" : "false")
+                  << ", \"input\": " << json_string(input) << '}';
+    }
+    std::cout << "\n  ],\n  \"growth\": {\"class\": \"" << (is_exponential ? "exponential" : "polynomial")
+              << "\", \"degree\": " << degree << ", \"power_r2\": " << power_r2
+              << ", \"base_per_byte\": " << std::exp(rate) << ", \"exponential_r2\": " << exponential_r2
+              << ", \"step_limit_reached\": " << (limited ? "true" : "false") << "}\n}\n";
+    return is_exponential ? 1 : 0;
+}
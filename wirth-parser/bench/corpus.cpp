@@ -0,0 +1,200 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alloc_stats.h"
+#include "ast.h"
+#include "handwritten.h"
+#include "parser.h"
+#include "structural.h"
+#include "tokens.h"
+#include "utf8.h"
+#include "util.h"
+
+#include "csv_recognizer.h"
+#include "expr_recognizer.h"
+#include "json_recognizer.h"
+
+/*
+A benchmark over a corpus of grammars. For each grammar it times syntax(), the
+valid_utf8() pass that syntax() starts with and its share of the parse, the
+fmt() code generation, and syntax() in the scope of an Ast_interner, whose
+count and bytes of shared nodes it also prints. In a build with allocation
+stats it prints the bytes the tree holds with and without the interner. It
+times the structural index of the grammar against lex(), and indexed_syntax()
+and parallel_syntax() against syntax(), with the speedup of each. For the
+grammars that come with a sample input it times the recognizer that
+wirth-parser --recognizer generated from the grammar against a handwritten
+recognizer for the same language. Results are printed as JSON with the median
+time of each measurement.
+*/
+
+namespace {
+
+template <Parser P>
+bool recognizes(P start, std::string_view input)
+{
+    auto const result = start(input);
+    return result && std::invoke(skip_whitespace, result->second)->second.empty();
+}
+
+void print_time(std::string_view name, std::pair<double, bool> timing, std::size_t bytes)
+{
+    std::cout << "\"" << name << "\": {\"ok\": " << (timing.second ? "true" : "false")
+              << ", \"median_us\": " << timing.first * 1e6
+              << ", \"mb_per_s\": " << static_cast<double>(bytes) / timing.first / 1e6 << '}';
+}
+
+struct Language
+{
+    std::string name;
+    std::string grammar;
+    bool (*generated)(std::string_view);
+    bool (*handwritten)(std::string_view);
+    std::string sample;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string corpus = WIRTH_PARSER_CORPUS;
+    std::size_t iterations = 20;
+    std::size_t threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{argv[i]};
+        if (arg == "--corpus" && i + 1 != argc) {
+            corpus = argv[++i];
+        } else if (arg == "--iterations" && i + 1 != argc) {
+            iterations = std::max<std::size_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--threads" && i + 1 != argc) {
+            threads = std::stoull(argv[++i]);
+        } else {
+            std::cerr << "Usage: wirth-parser-corpus [--corpus <directory>] [--iterations <n>] [--threads <n>]\n";
+            return 2;
+        }
+    }
+
+    std::vector<Language> const languages{
+        {"json", corpus + "/json.wsn", [](std::string_view x){ return recognizes(json_grammar::json, x); }, handwritten::json, "json.sample.json"},
+        {"csv", corpus + "/csv.wsn", [](std::string_view x){ return recognizes(csv_grammar::file, x); }, handwritten::csv, "csv.sample.csv"},
+        {"expr", corpus + "/expr.wsn", [](std::string_view x){ return recognizes(expr_grammar::program, x); }, handwritten::expr, "expr.sample.txt"},
+        {"unicode", corpus + "/unicode.wsn", nullptr, nullptr, {}},
+        {"generated", WIRTH_PARSER_GENERATED_GRAMMAR, nullptr, nullptr, {}},
+        {"generated_pretty", WIRTH_PARSER_PRETTY_GRAMMAR, nullptr, nullptr, {}},
+    };
+
+    bool all_ok = true;
+    std::cout << std::fixed << std::setprecision(3) << "{\n  \"iterations\": " << iterations << ",\n  \"grammars\": [";
+    for (auto const& language : languages) {
+        auto const grammar = read_file(language.grammar);
+        if (!grammar) {
+            std::cerr << "Error: Could not read " << language.grammar << ".\n";
+            return 1;
+        }
+        auto const parsed = syntax(*grammar);
+        if (!parsed) {
+            std::cerr << "Error: Could not parse " << language.grammar << ".\n";
+            return 1;
+        }
+
+        std::cout << (&language == &languages.front() ? "\n" : ",\n")
+                  << "    {\n      \"name\": \"" << language.name << "\", \"grammar_bytes\": " << grammar->size() << ",\n      ";
+        auto const parse = median_time(iterations, [&]{ return syntax(*grammar).has_value(); });
+        print_time("syntax", parse, grammar->size());
+        std::cout << ",\n      ";
+        auto const validate = median_time(iterations, [&]{ return valid_utf8(*grammar); });
+        print_time("valid_utf8", validate, grammar->size());
+        std::cout << ",\n      \"validation_share\": " << validate.first / parse.first << ",\n      ";
+        auto const format = median_time(iterations, [&]{ return !fmt(parsed->first, 0).empty(); });
+        print_time("fmt", format, grammar->size());
+        std::cout << ",\n      ";
+        auto const interned = median_time(iterations, [&]{ Ast_interner interner; return syntax(*grammar).has_value(); });
+        print_time("syntax_interned", interned, grammar->size());
+        {
+            Ast_interner interner;
+            syntax(*grammar);
+            std::cout << ",\n      \"nodes\": " << interner.nodes() << ", \"shared_nodes\": " << interner.shared()
+                      << ", \"node_bytes\": " << interner.bytes() << ", \"shared_node_bytes\": " << interner.shared_bytes();
+        }
+        if (alloc_stats_enabled()) {
+            // The bytes each tree holds on to, including its strings and vectors.
+            auto const live = [](std::string_view phase)
+            {
+                for (auto const& st : alloc_stats()) {
+                    if (st.phase == phase) return st.live;
+                }
+                return std::int64_t{0};
+            };
+            auto const plain = [&]{ Alloc_phase phase{"corpus_tree"}; return syntax(*grammar); }();
+            auto const shared = [&]{ Alloc_phase phase{"corpus_interned"}; Ast_interner interner; return syntax(*grammar); }();
+            std::cout << ",\n      \"tree_live_bytes\": " << live("corpus_tree")
+                      << ", \"tree_live_bytes_interned\": " << live("corpus_interned");
+        }
+        std::cout << ",\n      ";
+        auto const index = median_time(iterations, [&]{ return !structural_index(*grammar).empty(); });
+        print_time("structural_index", index, grammar->size());
+        std::cout << ",\n      ";
+        auto const lexed = median_time(iterations, [&]{ auto const tokens = lex(*grammar); return tokens && tokens->second.empty(); });
+        print_time("lex", lexed, grammar->size());
+        std::cout << ",\n      ";
+        auto const indexed = median_time(iterations, [&]{ return indexed_syntax(*grammar).has_value(); });
+        print_time("indexed_syntax", indexed, grammar->size());
+        std::cout << ",\n      ";
+        auto const parallel = median_time(iterations, [&]{ return parallel_syntax(*grammar, threads).has_value(); });
+        print_time("parallel_syntax", parallel, grammar->size());
+        std::cout << ",\n      \"indexed_speedup\": " << parse.first / indexed.first
+                  << ", \"parallel_speedup\": " << parse.first / parallel.first;
+        all_ok = all_ok && parse.second && validate.second && format.second && interned.second && index.second && lexed.second && indexed.second && parallel.second;
+
+        if (language.generated) {
+            auto const sample_path = corpus + "/" + language.sample;
+            auto const sample = read_file(sample_path);
+            if (!sample) {
+                std::cerr << "Error: Could not read " << sample_path << ".\n";
+                return 1;
+            }
+            std::cout << ",\n      \"sample_bytes\": " << sample->size() << ",\n      ";
+            auto const gen = median_time(iterations, [&]{ return language.generated(*sample); });
+            print_time("generated_recognizer", gen, sample->size());
+            std::cout << ",\n      ";
+            auto const hand = median_time(iterations, [&]{ return language.handwritten(*sample); });
+            print_time("handwritten_recognizer", hand, sample->size());
+            all_ok = all_ok && gen.second && hand.second;
+        }
+        std::cout << "\n    }";
+    }
+    std::cout << "\n  ]\n}\n";
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ast.h"
+#include "earley.h"
+#include "generator.h"
+#include "parser.h"
+#include "util.h"
+
+#include "backtrack_recognizer.h"
+
+/*
+A benchmark of the Earley parser against the combinator parsers. On generated
+grammars of growing size it times earley_syntax() against syntax() from
+parser.cpp, which is linear, and checks that both build the same tree. On the
+backtrack grammar of the corpus, which has two alternatives that start with the
+same production, it times an Earley_parser against the recognizer that
+wirth-parser --recognizer generated, which is exponential in the nesting depth
+of the input. Each run of the recognizer is bounded by a step budget. Results
+are printed as JSON with the median time of each measurement and the depth at
+which the Earley parser becomes faster.
+*/
+
+namespace {
+
+// A sentence of the backtrack grammar whose parentheses nest depth deep, with
+// the last alternative taken at each level.
+std::string nested(std::size_t depth)
+{
+    std::string ret = "z";
+    for (std::size_t i = 0; i != depth; ++i) ret = "(" + ret + "y)";
+    return ret + "y";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::size_t iterations = 5;
+    std::size_t max_bytes = 1 << 20;
+    std::size_t max_depth = 32;
+    std::uint64_t max_steps = 100'000'000;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{argv[i]};
+        if (arg == "--iterations" && i + 1 != argc) {
+            iterations = std::max<std::size_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--max-bytes" && i + 1 != argc) {
+            max_bytes = std::stoull(argv[++i]);
+        } else if (arg == "--max-depth" && i + 1 != argc) {
+            max_depth = std::stoull(argv[++i]);
+        } else if (arg == "--max-steps" && i + 1 != argc) {
+            max_steps = std::stoull(argv[++i]);
+        } else {
+            std::cerr << "Usage: wirth-parser-earley [--iterations <n>] [--max-bytes <n>] [--max-depth <n>] [--max-steps <n>]\n";
+            return 2;
+        }
+    }
+
+    auto const self = syntax(earley_self_grammar);
+
+    Generator_options options;
+    options.seed = 1;
+    options.lexical = {"identifier", "literal"};
+    Parse_budget budget;
+    budget.steps = max_steps;
+
+    bool all_ok = true;
+    std::size_t previous = 0;
+    std::cout << std::fixed << std::setprecision(3) << "{\n  \"iterations\": " << iterations << ",\n  \"syntax\": [";
+    for (std::size_t bytes = 1024; bytes <= max_bytes; bytes *= 4) {
+        std::ostringstream out;
+        options.size = bytes;
+        generate(self->first, "syntax", options, out);
+        auto const grammar = out.str();
+        // The last sentence is always completed, so small sizes can give the same grammar.
+        if (grammar.size() == previous) continue;
+        auto const expected = syntax(grammar);
+        auto const parsed = earley_syntax(grammar);
+        auto const same = expected && parsed && expected->second == parsed->second && fmt(expected->first, 0) == fmt(parsed->first, 0);
+        auto const combinators = median_time(iterations, [&]{ return syntax(grammar).has_value(); });
+        auto const earley = median_time(iterations, [&]{ return earley_syntax(grammar).has_value(); });
+        all_ok = all_ok && same && combinators.second && earley.second;
+        std::cout << (previous == 0 ? "\n" : ",\n")
+                  << "    {\"bytes\": " << grammar.size() << ", \"same_tree\": " << (same ? "true" : "false")
+                  << ", \"syntax_us\": " << combinators.first * 1e6 << ", \"earley_us\": " << earley.first * 1e6
+                  << ", \"earley_mb_per_s\": " << static_cast<double>(grammar.size()) / earley.first / 1e6
+                  << ", \"slowdown\": " << earley.first / combinators.first << '}';
+        previous = grammar.size();
+    }
+
+    auto const backtrack = syntax("a = b \"x\" | b \"y\".\nb = \"(\" a \")\" | \"z\".\n");
+    Earley_parser const earley_backtrack{backtrack->first, "a"};
+    // The depth from which the Earley parser stays faster, or none.
+    auto crossover = max_depth + 1;
+    std::cout << "\n  ],\n  \"backtrack\": [";
+    for (std::size_t depth = 0; depth <= max_depth; ++depth) {
+        auto const input = nested(depth);
+        auto const bounded = bounded_parse(backtrack_grammar::a, std::string_view{input}, budget);
+        auto const combinators = bounded.exhausted
+            ? std::pair{0.0, false}
+            : median_time(iterations, [&]{ return backtrack_grammar::a(input).has_value(); });
+        auto const steps = parse_steps;
+        earley_backtrack(input);
+        auto const earley_steps = parse_steps - steps;
+        auto const earley = median_time(iterations, [&]{ return earley_backtrack(input).has_value(); });
+        all_ok = all_ok && earley.second;
+        if (!bounded.exhausted && combinators.first <= earley.first) {
+            crossover = max_depth + 1;
+        } else if (crossover > max_depth) {
+            crossover = depth;
+        }
+        std::cout << (depth == 0 ? "\n" : ",\n")
+                  << "    {\"depth\": " << depth << ", \"bytes\": " << input.size()
+                  << ", \"recognizer_steps\": " << bounded.steps
+                  << ", \"recognizer_limited\": " << (bounded.exhausted ? "true" : "false")
+                  << ", \"recognizer_us\": ";
+        if (bounded.exhausted) std::cout << "null"; else std::cout << combinators.first * 1e6;
+        std::cout << ", \"earley_steps\": " << earley_steps << ", \"earley_us\": " << earley.first * 1e6 << '}';
+        if (bounded.exhausted) break;
+    }
+    std::cout << "\n  ],\n  \"crossover_depth\": ";
+    if (crossover <= max_depth) std::cout << crossover; else std::cout << "null";
+    std::cout << "\n}\n";
+    return all_ok ? 0 : 1;
+}
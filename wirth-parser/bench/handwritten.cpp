@@ -0,0 +1,306 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <cstring>
+#include <string_view>
+
+#include "handwritten.h"
+
+namespace {
+
+class Cursor
+{
+    char const* at_;
+    char const* end_;
+
+public:
+
+    explicit Cursor(std::string_view input)
+        : at_{input.data()}, end_{input.data() + input.size()}
+    {}
+
+    bool done() const { return at_ == end_; }
+
+    char peek() const { return at_ == end_ ? '\0' : *at_; }
+
+    char peek(std::size_t ahead) const
+    {
+        return static_cast<std::size_t>(end_ - at_) > ahead ? at_[ahead] : '\0';
+    }
+
+    void next(std::size_t n = 1) { at_ += n; }
+
+    bool eat(char ch)
+    {
+        if (peek() != ch) return false;
+        ++at_;
+        return true;
+    }
+
+    bool eat(std::string_view st)
+    {
+        if (static_cast<std::size_t>(end_ - at_) < st.size() || std::memcmp(at_, st.data(), st.size()) != 0) return false;
+        at_ += st.size();
+        return true;
+    }
+
+    void skip_space()
+    {
+        while (at_ != end_ && (*at_ == ' ' || *at_ == '\t' || *at_ == '\n' || *at_ == '\r' || *at_ == '\f' || *at_ == '\v')) ++at_;
+    }
+};
+
+bool is_digit(char ch) { return ch >= '0' && ch <= '9'; }
+
+bool is_letter(char ch) { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'); }
+
+bool is_hex(char ch) { return is_digit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F'); }
+
+bool digits(Cursor& in)
+{
+    if (!is_digit(in.peek())) return false;
+    while (is_digit(in.peek())) in.next();
+    return true;
+}
+
+// JSON
+
+bool json_value(Cursor& in);
+
+bool json_string(Cursor& in)
+{
+    if (!in.eat('"')) return false;
+    while (!in.done() && in.peek() != '"') {
+        if (in.eat('\\')) {
+            if (in.eat('u')) {
+                for (int i = 0; i != 4; ++i) {
+                    if (!is_hex(in.peek())) return false;
+                    in.next();
+                }
+            } else if (std::strchr("\"\\/bfnrt", in.peek()) && !in.done()) {
+                in.next();
+            }
+        } else {
+            in.next();
+        }
+    }
+    return in.eat('"');
+}
+
+bool json_number(Cursor& in)
+{
+    in.eat('-');
+    if (!in.eat('0') && !digits(in)) return false;
+    if (in.peek() == '.' && is_digit(in.peek(1))) {
+        in.next();
+        digits(in);
+    }
+    if (in.peek() == 'e' || in.peek() == 'E') {
+        auto const sign = in.peek(1) == '+' || in.peek(1) == '-';
+        if (is_digit(in.peek(sign ? 2 : 1))) {
+            in.next(sign ? 2 : 1);
+            digits(in);
+        }
+    }
+    return true;
+}
+
+template <typename Item>
+bool json_list(Cursor& in, char close, Item item)
+{
+    in.skip_space();
+    if (in.eat(close)) return true;
+    do {
+        if (!item(in)) return false;
+        in.skip_space();
+    } while (in.eat(','));
+    return in.eat(close);
+}
+
+bool json_value(Cursor& in)
+{
+    in.skip_space();
+    switch (in.peek()) {
+        case '{':
+            in.next();
+            return json_list(in, '}', [](Cursor& x)
+            {
+                x.skip_space();
+                if (!json_string(x)) return false;
+                x.skip_space();
+                return x.eat(':') && json_value(x);
+            });
+        case '[':
+            in.next();
+            return json_list(in, ']', json_value);
+        case '"':
+            return json_string(in);
+        case 't':
+            return in.eat("true");
+        case 'f':
+            return in.eat("false");
+        case 'n':
+            return in.eat("null");
+        default:
+            return json_number(in);
+    }
+}
+
+// CSV
+
+bool csv_field(Cursor& in)
+{
+    if (in.eat('"')) {
+        while (!in.done()) {
+            if (in.peek() == '"') {
+                if (in.peek(1) != '"') break;
+                in.next(2);
+            } else {
+                in.next();
+            }
+        }
+        return in.eat('"');
+    }
+    while (is_letter(in.peek()) || is_digit(in.peek()) || (in.peek() != '\0' && std::strchr(" .-_:/+@", in.peek()))) {
+        in.next();
+    }
+    return true;
+}
+
+// C-like expressions
+
+bool expr_expression(Cursor& in);
+
+bool expr_identifier(Cursor& in)
+{
+    if (!is_letter(in.peek()) && in.peek() != '_') return false;
+    while (is_letter(in.peek()) || is_digit(in.peek()) || in.peek() == '_') in.next();
+    return true;
+}
+
+bool expr_unary(Cursor& in)
+{
+    in.skip_space();
+    if (in.eat('-') || in.eat('!')) return expr_unary(in);
+    if (digits(in)) return true;
+    if (expr_identifier(in)) {
+        auto probe = in;
+        probe.skip_space();
+        if (!probe.eat('(')) return true;
+        in = probe;
+        in.skip_space();
+        if (in.eat(')')) return true;
+        do {
+            if (!expr_expression(in)) return false;
+            in.skip_space();
+        } while (in.eat(','));
+        return in.eat(')');
+    }
+    if (!in.eat('(') || !expr_expression(in)) return false;
+    in.skip_space();
+    return in.eat(')');
+}
+
+// The binary operators from loosest to tightest, longest first within a level.
+constexpr std::string_view levels[][4] = {
+    {"||"}, {"&&"}, {"==", "!="}, {"<=", ">=", "<", ">"}, {"+", "-"}, {"*", "/", "%"},
+};
+
+bool expr_level(Cursor& in, std::size_t level)
+{
+    if (level == std::size(levels)) return expr_unary(in);
+    if (!expr_level(in, level + 1)) return false;
+    for (;;) {
+        auto probe = in;
+        probe.skip_space();
+        bool found = false;
+        for (auto const op : levels[level]) {
+            if (!op.empty() && probe.eat(op)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) return true;
+        auto const before = in;
+        in = probe;
+        if (!expr_level(in, level + 1)) {
+            in = before;
+            return true;
+        }
+    }
+}
+
+bool expr_expression(Cursor& in)
+{
+    return expr_level(in, 0);
+}
+
+} // namespace
+
+namespace handwritten {
+
+bool json(std::string_view input)
+{
+    Cursor in{input};
+    if (!json_value(in)) return false;
+    in.skip_space();
+    return in.done();
+}
+
+bool csv(std::string_view input)
+{
+    Cursor in{input};
+    do {
+        do {
+            if (!csv_field(in)) return false;
+        } while (in.eat(','));
+    } while (in.eat("\r\n") || in.eat('\n'));
+    in.skip_space();
+    return in.done();
+}
+
+bool expr(std::string_view input)
+{
+    Cursor in{input};
+    for (;;) {
+        in.skip_space();
+        auto const before = in;
+        if (!expr_identifier(in)) {
+            in = before;
+            break;
+        }
+        in.skip_space();
+        if (in.peek() != '=' || in.peek(1) == '=') return false;
+        in.next();
+        if (!expr_expression(in)) return false;
+        in.skip_space();
+        if (!in.eat(';')) return false;
+    }
+    return in.done();
+}
+
+} // namespace handwritten
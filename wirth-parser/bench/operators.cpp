@@ -0,0 +1,209 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "parsing.h"
+#include "util.h"
+
+/*
+A benchmark of operators() against a grammar with one production per
+precedence level, level = next {op next}, over ten levels of left-associative
+binary operators on integers. Both parse the same random expressions of 0 to
+11 operators, and their values are compared. Results are printed as JSON with
+the median time of each and the steps counted in parse_steps.
+*/
+
+namespace {
+
+using Value = std::uint64_t;
+
+// Lowest precedence first.
+constexpr std::string_view tokens[] = {"||", "&&", "|", "^", "&", "==", "<", "<<", "+", "*"};
+constexpr std::size_t levels = std::size(tokens);
+
+constexpr Value (*folds[])(Value, Value) = {
+    [](Value x, Value y) -> Value { return x || y; },
+    [](Value x, Value y) -> Value { return x && y; },
+    [](Value x, Value y) -> Value { return x | y; },
+    [](Value x, Value y) -> Value { return x ^ y; },
+    [](Value x, Value y) -> Value { return x & y; },
+    [](Value x, Value y) -> Value { return x == y; },
+    [](Value x, Value y) -> Value { return x < y; },
+    [](Value x, Value y) -> Value { return x << (y & 63); },
+    [](Value x, Value y) -> Value { return x + y; },
+    [](Value x, Value y) -> Value { return x * y; },
+};
+
+constexpr Parser auto number = chain(
+    digit,
+    [](char x){ return reduce_many(Value(x - '0'), digit, [](Value n, char y){ return n * 10 + Value(y - '0'); }); }
+);
+
+template <std::size_t Level>
+auto layered(std::string_view input) -> Parsed_t<Value>
+{
+    if constexpr (Level == levels) {
+        return number(input);
+    } else {
+        static auto const parser = chain(
+            layered<Level + 1>,
+            [](Value first)
+            {
+                return reduce_many(
+                    first,
+                    sequence(
+                        [](auto, auto, Value x){ return x; },
+                        skip_sequence(skip_whitespace, skip_str(tokens[Level])),
+                        skip_whitespace,
+                        layered<Level + 1>
+                    ),
+                    folds[Level]
+                );
+            }
+        );
+        return parser(input);
+    }
+}
+
+auto table_operators()
+{
+    return operators<decltype(number)>(
+        {
+            {tokens[0], 1, Associativity::left, folds[0]},
+            {tokens[1], 2, Associativity::left, folds[1]},
+            {tokens[2], 3, Associativity::left, folds[2]},
+            {tokens[3], 4, Associativity::left, folds[3]},
+            {tokens[4], 5, Associativity::left, folds[4]},
+            {tokens[5], 6, Associativity::left, folds[5]},
+            {tokens[6], 7, Associativity::left, folds[6]},
+            {tokens[7], 8, Associativity::left, folds[7]},
+            {tokens[8], 9, Associativity::left, folds[8]},
+            {tokens[9], 10, Associativity::left, folds[9]},
+        },
+        number
+    );
+}
+
+std::vector<std::string> expressions(std::size_t count)
+{
+    std::uint64_t state = 1;
+    auto const below = [&state](std::uint64_t n)
+    {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        return (state >> 33) % n;
+    };
+    std::vector<std::string> ret;
+    for (std::size_t i = 0; i != count; ++i) {
+        auto st = std::to_string(below(1000));
+        for (auto n = below(12); n != 0; --n) {
+            st += ' ';
+            st += tokens[below(levels)];
+            st += ' ';
+            st += std::to_string(below(1000));
+        }
+        ret.push_back(std::move(st));
+    }
+    return ret;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::size_t iterations = 20;
+    std::size_t count = 2000;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg{argv[i]};
+        if (arg == "--iterations" && i + 1 != argc) {
+            iterations = std::max<std::size_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--expressions" && i + 1 != argc) {
+            count = std::max<std::size_t>(1, std::stoull(argv[++i]));
+        } else {
+            std::cerr << "Usage: wirth-parser-operators [--iterations <n>] [--expressions <n>]\n";
+            return 2;
+        }
+    }
+
+    auto const inputs = expressions(count);
+    std::size_t bytes = 0;
+    for (auto const& x : inputs) bytes += x.size();
+
+    auto const table = table_operators();
+    bool same = true;
+    for (auto const& x : inputs) {
+        auto const a = table(x);
+        auto const b = layered<0>(x);
+        same = same && a && b && a->first == b->first && a->second.empty() && b->second.empty();
+    }
+
+    // Parses every expression, and returns whether all of them parsed to the end.
+    auto const run = [&inputs](auto const& parser)
+    {
+        bool ok = true;
+        for (auto const& x : inputs) {
+            auto const result = parser(x);
+            ok = ok && result && result->second.empty();
+        }
+        return ok;
+    };
+    auto const steps = [&run](auto const& parser)
+    {
+        auto const before = parse_steps;
+        run(parser);
+        return parse_steps - before;
+    };
+
+    auto const table_time = median_time(iterations, [&]{ return run(table); });
+    auto const table_steps = steps(table);
+    auto const layered_time = median_time(iterations, [&]{ return run(layered<0>); });
+    auto const layered_steps = steps(layered<0>);
+
+    auto const print = [&](std::string_view name, std::pair<double, bool> timing, std::uint64_t n)
+    {
+        std::cout << "  \"" << name << "\": {\"ok\": " << (timing.second ? "true" : "false")
+                  << ", \"median_us\": " << timing.first * 1e6
+                  << ", \"ns_per_expression\": " << timing.first * 1e9 / static_cast<double>(count)
+                  << ", \"mb_per_s\": " << static_cast<double>(bytes) / timing.first / 1e6
+                  << ", \"steps\": " << n << "},\n";
+    };
+    std::cout << std::fixed << std::setprecision(3)
+              << "{\n  \"iterations\": " << iterations << ",\n  \"expressions\": " << count
+              << ",\n  \"bytes\": " << bytes << ",\n  \"levels\": " << levels
+              << ",\n  \"same_values\": " << (same ? "true" : "false") << ",\n";
+    print("operators", table_time, table_steps);
+    print("layered", layered_time, layered_steps);
+    std::cout << "  \"speedup\": " << layered_time.first / table_time.first << "\n}\n";
+    return same && table_time.second && layered_time.second ? 0 : 1;
+}
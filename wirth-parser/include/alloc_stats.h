@@ -0,0 +1,107 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+/*
+Allocation accounting
+
+Configuring the build with -DWIRTH_PARSER_ALLOC_STATS=ON replaces the global
+operator new and delete with versions that count allocations per phase. A
+phase is a named scope opened with Alloc_phase. Phases nest, and an allocation
+is charged to the innermost phase of its thread. Freed bytes are credited back
+to the phase that allocated them, so live and peak bytes per phase remain
+accurate when memory outlives its phase.
+
+The productions in parser.cpp open a detail phase named after themselves,
+which only counts while alloc_track_details(true) is in effect. Without the
+build option all of this compiles to nothing, and alloc_stats() is empty.
+*/
+
+struct Alloc_stats
+{
+    std::string_view phase;
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+    std::int64_t live = 0;
+    std::int64_t peak = 0;
+    std::size_t copies = 0;
+};
+
+class Alloc_phase
+{
+#ifdef WIRTH_PARSER_ALLOC_STATS
+    std::uint32_t previous_;
+    bool active_;
+#endif
+
+public:
+
+    // name must have static storage duration, like a string literal.
+    explicit Alloc_phase(char const* name, bool detail = false);
+
+    Alloc_phase(Alloc_phase const&) = delete;
+
+    Alloc_phase& operator=(Alloc_phase const&) = delete;
+
+    ~Alloc_phase();
+};
+
+// Counts a copy of an Ast in the innermost phase. Ast's copy constructor calls
+// it, so the copies that moving values through the parsers saves can be seen
+// next to the allocations.
+void alloc_count_copy();
+
+#ifndef WIRTH_PARSER_ALLOC_STATS
+inline Alloc_phase::Alloc_phase(char const*, bool) {}
+
+inline Alloc_phase::~Alloc_phase() {}
+
+inline void alloc_count_copy() {}
+#endif
+
+bool alloc_stats_enabled();
+
+void alloc_track_details(bool on);
+
+// Returns the counters of every phase that has been opened, and of
+// allocations made outside any phase, under the name "other".
+std::vector<Alloc_stats> alloc_stats();
+
+// Clears the counts, bytes and copies of every phase. Live bytes are kept, as
+// the blocks still allocated will be freed later, and each peak is lowered to
+// the live bytes.
+void alloc_stats_reset();
+
+// Prints a table of the counters, with allocations and bytes per input byte.
+void alloc_report(std::ostream& out, std::size_t input_size);
@@ -0,0 +1,112 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+
+struct Grammar_problem
+{
+    enum class Kind
+    {
+        // Errors, which make the parser fail to terminate or to be linear.
+        undefined_identifier,
+        left_recursion,
+        nullable_repetition,
+        unbounded_backtracking,
+        // Warnings, where the parser has to backtrack.
+        alternative_conflict,
+        optional_conflict,
+        repetition_conflict,
+    };
+
+    Kind kind;
+    std::string production;
+    std::string message;
+
+    bool is_error() const { return kind < Kind::alternative_conflict; }
+};
+
+struct Production_analysis
+{
+    std::string name;
+    bool nullable = false;
+    // The bytes a sentence can start with, and the bytes that can follow one.
+    std::string first;
+    std::string follow;
+    bool left_recursive = false;
+    // How many times the same input can be parsed again in nested choices
+    // that start from this production. Empty if there is no bound.
+    std::optional<std::size_t> backtracking_depth;
+};
+
+struct Grammar_analysis
+{
+    std::vector<Production_analysis> productions;
+    std::vector<Grammar_problem> problems;
+    std::optional<std::size_t> max_backtracking_depth;
+
+    // Whether the grammar has no errors, so that its parser terminates, and
+    // backtracking is bounded, which keeps parse time linear in the input.
+    bool linear() const;
+};
+
+/*
+Analyzes a Syntax Ast, with the first production as the start, the way the
+recognizers of emit_recognizer() parse it. The sets are computed over bytes
+and ignore whitespace between tokens, and the built-in identifiers of
+emit_recognizer() stand for their bytes.
+
+Nullable, FIRST and FOLLOW sets are computed for each production. With them,
+alternatives that can start with the same byte are reported as conflicts,
+except in a choice between single literals, which takes the longest match.
+So are optional and repeated parts that can start with a byte that can also
+follow them. These backtrack, or take the greedy path where the grammar meant
+the other. Repetitions of something nullable never end under reduce_many(),
+and left recursion never ends in a recursive descent parser, so both are
+errors.
+
+The backtracking depth is estimated from references to a production at the
+start of two conflicting alternatives, where the second alternative parses
+the same input again. Through recursion such nested re-parses can multiply
+without bound, which makes parse time exponential, and is an error.
+
+Lexical productions, as in Recognizer_options, take the longest match, so
+their optional and repeated parts are not checked against what follows them.
+*/
+Grammar_analysis analyze(Ast const& syntax, std::set<std::string, std::less<>> const& lexical = {});
+
+// Writes the analysis as JSON, for gating a build on it.
+void write_json(Grammar_analysis const& analysis, std::ostream& out);
@@ -27,18 +27,32 @@ For more information, please refer to <http://unlicense.org>
 
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include "alloc_stats.h"
+
+class Ast_interner;
+
 class Ast
 {
     struct Concept
     {
         virtual ~Concept() = default;
 
-        virtual std::string fmt_(std::string::size_type in) const = 0;
+        virtual void children_(std::vector<Ast const*>& out) const = 0;
+
+        virtual std::string::size_type indent_(std::string::size_type in, std::size_t child) const = 0;
+
+        virtual std::string fmt_(std::string::size_type in, std::span<std::string const> children) const = 0;
     };
 
     template <typename T>
@@ -46,52 +60,311 @@ class Ast
     {
         explicit Model(T obj) : data_(std::move(obj)) {}
 
-        std::string fmt_(std::string::size_type in) const override { return fmt(data_, in); }
+        void children_(std::vector<Ast const*>& out) const override { children(data_, out); }
+
+        std::string::size_type indent_(std::string::size_type in, std::size_t child) const override
+        {
+            return child_indent(data_, in, child);
+        }
+
+        std::string fmt_(std::string::size_type in, std::span<std::string const> children) const override
+        {
+            return fmt(data_, in, children);
+        }
 
         T data_;
     };
 
     std::shared_ptr<Concept const> self_;
 
+    // The innermost interner in scope on this thread, if any.
+    static constinit inline thread_local Ast_interner* interner_ = nullptr;
+
+    // Returns the interner's entry for a key, which is empty if no live node
+    // has the key, and counts a node of the given size.
+    static std::weak_ptr<Concept const>& interned(std::string_view key, std::size_t size);
+
+    template <typename T>
+    static std::shared_ptr<Concept const> make(T obj)
+    {
+        if (!interner_) return std::make_shared<Model<T>>(std::move(obj));
+
+        thread_local std::string key, id;
+        thread_local std::vector<Ast const*> kids;
+        key.clear();
+        if (!hash_cons_key(obj, key)) return std::make_shared<Model<T>>(std::move(obj));
+
+        // A node is identified by its type, the identities of its children,
+        // which are already interned, and the data it adds to them.
+        static constexpr char type_tag = 0;
+        kids.clear();
+        children(obj, kids);
+        id.clear();
+        auto const append = [](auto const& x){ id.append(reinterpret_cast<char const*>(&x), sizeof x); };
+        append(&type_tag);
+        append(kids.size());
+        for (auto const* kid : kids) append(kid->self_.get());
+        id += key;
+
+        // Not make_shared, which would put the node in the block of the
+        // reference counts that the interner's weak_ptr keeps allocated.
+        auto& entry = interned(id, sizeof(Model<T>));
+        if (auto node = entry.lock()) return node;
+        auto node = std::shared_ptr<Model<T> const>(new Model<T>(std::move(obj)));
+        entry = node;
+        return node;
+    }
+
 public:
 
     template <typename T>
-    explicit Ast(T obj) : self_(std::make_shared<Model<T>>(std::move(obj))) {}
+    requires (!std::same_as<T, Ast>)
+    explicit Ast(T obj) : self_(make(std::move(obj))) {}
+
+    Ast(Ast const& x) : self_(x.self_) { alloc_count_copy(); }
+
+    Ast(Ast&&) noexcept = default;
+
+    Ast& operator=(Ast x) noexcept
+    {
+        self_.swap(x.self_);
+        return *this;
+    }
+
+    // Deep trees are torn down with an explicit stack instead of recursively.
+    ~Ast();
+
+    friend void children(Ast const& x, std::vector<Ast const*>& out);
 
     friend std::string fmt(Ast const& x, std::string::size_type in);
+
+    template <typename T>
+    friend T const* ast_cast(Ast const& x);
+
+    // Returns whether two nodes are the same node. For nodes built in the
+    // scope of one Ast_interner this is structural equality.
+    friend bool identical(Ast const& x, Ast const& y) noexcept
+    {
+        return x.self_ == y.self_;
+    }
+
+    friend class Ast_interner;
 };
 
+// Hash-consing of nodes. While an interner is in scope on a thread, building a
+// node that is structurally equal to a live node built in that scope returns
+// the existing node, so equal subtrees share one allocation and identical()
+// compares them in constant time. The interner holds weak references, so a
+// node is freed with the last Ast that refers to it, and the entries of freed
+// nodes are dropped whenever the table has doubled. Only node types with a
+// hash_cons_key() overload that returns true are shared, which excludes Lazy.
+class Ast_interner
+{
+public:
+
+    Ast_interner();
+
+    ~Ast_interner();
+
+    Ast_interner(Ast_interner const&) = delete;
+
+    Ast_interner& operator=(Ast_interner const&) = delete;
+
+    // The number of nodes built in scope, and how many of them were existing
+    // nodes returned again.
+    std::size_t nodes() const;
+
+    std::size_t shared() const;
+
+    // The same in bytes of node objects, not counting the strings and vectors
+    // of children that they own.
+    std::size_t bytes() const;
+
+    std::size_t shared_bytes() const;
+
+private:
+
+    friend class Ast;
+
+    struct Hash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>{}(key); }
+    };
+
+    std::unordered_map<std::string, std::weak_ptr<Ast::Concept const>, Hash, std::equal_to<>> table_;
+    std::size_t sweep_at_ = 1024;
+    std::size_t nodes_ = 0;
+    std::size_t shared_ = 0;
+    std::size_t bytes_ = 0;
+    std::size_t shared_bytes_ = 0;
+    Ast_interner* outer_;
+};
+
+// A node that stands for a tree that is parsed from its source text the first
+// time it is needed, so that parts of a grammar nobody reads are never built.
+// Copies share the parse, and threads forcing it at the same time parse once.
+// The source text must outlive the node.
+class Lazy
+{
+public:
+
+    using Parse = Ast (*)(std::string_view);
+
+    Lazy(std::string_view source, Parse parse);
+
+    std::string_view source() const;
+
+    // Parses the source on first use. If the parse throws, the exception is
+    // passed on and the next call tries again.
+    Ast const& get() const;
+
+private:
+
+    struct State;
+
+    std::shared_ptr<State> state_;
+};
+
+// Returns a pointer to the node's data if it holds a T, in the spirit of std::any_cast.
+// A Lazy node is forced and looked through, unless T is Lazy.
+template <typename T>
+T const* ast_cast(Ast const& x)
+{
+    if (auto const* model = dynamic_cast<Ast::Model<T> const*>(x.self_.get())) {
+        return &model->data_;
+    } else if constexpr (!std::same_as<T, Lazy>) {
+        if (auto const* lazy = dynamic_cast<Ast::Model<Lazy> const*>(x.self_.get())) {
+            return ast_cast<T>(lazy->data_.get());
+        }
+    }
+    return nullptr;
+}
+
+// Visits every node of a tree depth-first, calling pre before a node's
+// children and post after them. The walk keeps its own stack on the heap, so
+// nesting depth is not limited by the call stack. If pre returns a bool,
+// returning false skips the node's children, but post is still called.
+template <typename Pre, typename Post>
+void traverse(Ast const& root, Pre pre, Post post)
+{
+    struct Frame
+    {
+        Ast const* node;
+        bool entered;
+    };
+
+    std::vector<Frame> stack{{&root, false}};
+    std::vector<Ast const*> kids;
+    while (!stack.empty()) {
+        auto const [node, entered] = stack.back();
+        if (entered) {
+            stack.pop_back();
+            post(*node);
+            continue;
+        }
+        stack.back().entered = true;
+        if constexpr (std::same_as<std::invoke_result_t<Pre&, Ast const&>, bool>) {
+            if (!pre(*node)) continue;
+        } else {
+            pre(*node);
+        }
+        kids.clear();
+        children(*node, kids);
+        for (auto i = kids.rbegin(); i != kids.rend(); ++i) {
+            stack.push_back({*i, false});
+        }
+    }
+}
+
+// Nodes without children, such as literals and identifiers, only need to
+// overload fmt(x, in). Nodes with children overload all four functions below.
+template <typename T>
+void children(T const&, std::vector<Ast const*>&) {}
+
+template <typename T>
+std::string::size_type child_indent(T const&, std::string::size_type in, std::size_t) { return in; }
+
+template <typename T>
+std::string fmt(T const& x, std::string::size_type in, std::span<std::string const>) { return fmt(x, in); }
+
+// Appends the data a node holds besides its children to a key for hash-consing
+// it, and returns whether nodes of the type may be shared.
+template <typename T>
+bool hash_cons_key(T const&, std::string&) { return false; }
+
+void children(Lazy const& x, std::vector<Ast const*>& out);
+
+std::string::size_type child_indent(Lazy const& x, std::string::size_type in, std::size_t child);
+
+std::string fmt(Lazy const& x, std::string::size_type in, std::span<std::string const> children);
+
+std::string fmt(Lazy const& x, std::string::size_type in);
+
 struct Syntax
 {
     std::vector<Ast> productions;
 };
 
+void children(Syntax const& x, std::vector<Ast const*>& out);
+
+std::string::size_type child_indent(Syntax const& x, std::string::size_type in, std::size_t child);
+
+std::string fmt(Syntax const& x, std::string::size_type in, std::span<std::string const> children);
+
 std::string fmt(Syntax const& x, std::string::size_type in);
 
+bool hash_cons_key(Syntax const& x, std::string& key);
+
 struct Production
 {
     Ast identifier;
     Ast expression;
 };
 
+void children(Production const& x, std::vector<Ast const*>& out);
+
+std::string::size_type child_indent(Production const& x, std::string::size_type in, std::size_t child);
+
+std::string fmt(Production const& x, std::string::size_type in, std::span<std::string const> children);
+
 std::string fmt(Production const& x, std::string::size_type in);
 
+bool hash_cons_key(Production const& x, std::string& key);
+
 struct Expression
 {
     Ast term;
     std::vector<Ast> terms;
 };
 
+void children(Expression const& x, std::vector<Ast const*>& out);
+
+std::string::size_type child_indent(Expression const& x, std::string::size_type in, std::size_t child);
+
+std::string fmt(Expression const& x, std::string::size_type in, std::span<std::string const> children);
+
 std::string fmt(Expression const& x, std::string::size_type in);
 
+bool hash_cons_key(Expression const& x, std::string& key);
+
 struct Term
 {
     Ast factor;
     std::vector<Ast> factors;
 };
 
+void children(Term const& x, std::vector<Ast const*>& out);
+
+std::string::size_type child_indent(Term const& x, std::string::size_type in, std::size_t child);
+
+std::string fmt(Term const& x, std::string::size_type in, std::span<std::string const> children);
+
 std::string fmt(Term const& x, std::string::size_type in);
 
+bool hash_cons_key(Term const& x, std::string& key);
+
 struct Factor
 {
     enum class Type { gr_v, op_v, re_v, li_v, id_v };
@@ -100,8 +373,16 @@ struct Factor
     Ast value;
 };
 
+void children(Factor const& x, std::vector<Ast const*>& out);
+
+std::string::size_type child_indent(Factor const& x, std::string::size_type in, std::size_t child);
+
+std::string fmt(Factor const& x, std::string::size_type in, std::span<std::string const> children);
+
 std::string fmt(Factor const& x, std::string::size_type in);
 
+bool hash_cons_key(Factor const& x, std::string& key);
+
 struct Literal
 {
     std::string value;
@@ -109,6 +390,8 @@ struct Literal
 
 std::string fmt(Literal const& x, std::string::size_type in);
 
+bool hash_cons_key(Literal const& x, std::string& key);
+
 struct Identifier
 {
     std::string value;
@@ -116,9 +399,30 @@ struct Identifier
 
 std::string fmt(Identifier const& x, std::string::size_type in);
 
+bool hash_cons_key(Identifier const& x, std::string& key);
+
 struct Character
 {
     char value;
 };
 
 std::string fmt(Character const& x, std::string::size_type in);
+
+bool hash_cons_key(Character const& x, std::string& key);
+
+// Helpers for the modules that walk the tree of a grammar
+
+// The productions a grammar may use without defining them, which stand for the
+// character classes of parsing.h.
+inline constexpr std::string_view builtin_names[] = {"letter", "lower", "upper", "digit", "alphanum", "character", "newline"};
+
+constexpr bool is_builtin(std::string_view name)
+{
+    return std::ranges::find(builtin_names, name) != std::end(builtin_names);
+}
+
+// Returns in spaces, for the layout of generated code.
+std::string indent(std::string::size_type in);
+
+// Returns the literal of a term that consists of a single literal factor, or nullptr.
+Literal const* single_literal(Ast const& term);
@@ -0,0 +1,62 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <functional>
+#include <iosfwd>
+#include <set>
+#include <string>
+
+#include "ast.h"
+
+struct Recognizer_options
+{
+    // The namespace that holds the generated functions.
+    std::string name_space = "grammar";
+
+    // Productions that describe tokens. Outside of them, whitespace is skipped
+    // before each literal and each use of a lexical production or built-in.
+    std::set<std::string, std::less<>> lexical;
+};
+
+/*
+Writes a C++ header with a recognizer for each production of a Syntax Ast,
+built from the combinators in parsing.h. Each production becomes a function
+from std::string_view to Parsed_t<Unit>, so alternatives of any shape can be
+combined without semantic actions. Alternatives are tried in order, as in
+choice(), except that a choice between single literals takes the longest
+match.
+
+Like generate(), a grammar can use the built-in identifiers letter, lower,
+upper, digit, alphanum, character and newline. character matches any
+character other than a quote mark, and newline matches "\r\n" or "\n".
+Productions named like C++ keywords get a trailing underscore.
+
+Returns false if an identifier is not defined.
+*/
+bool emit_recognizer(Ast const& syntax, Recognizer_options const& options, std::ostream& out);
@@ -0,0 +1,122 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+#include "parsing.h"
+
+struct Earley_options
+{
+    // Productions that describe tokens, as in Recognizer_options. Outside of
+    // them, whitespace is skipped before each literal and each use of a
+    // lexical production or built-in, and a use of a lexical production takes
+    // its longest match.
+    std::set<std::string, std::less<>> lexical;
+};
+
+// A production in a parse tree, with the productions it was parsed from. A
+// lexical production has no children, only its text. Groups, optional and
+// repeated parts do not get nodes of their own: what they match is part of the
+// children of the production they are in. The views refer to the input and to
+// the parser that built the tree.
+struct Parse_node
+{
+    std::string_view production;
+
+    // The index of the alternative of the production that matched, or 0 for a
+    // lexical production.
+    std::size_t alternative = 0;
+
+    // The input the production matched, without whitespace before it.
+    std::string_view text;
+
+    std::vector<Parse_node> children;
+};
+
+/*
+A general parser for any grammar given as a Syntax Ast, for grammars that are
+not LL(1) and that make the backtracking combinators exponential.
+
+It is an Earley parser, with repetitions expanded into left-recursive rules
+and Leo's optimization of right recursion, so parse time is cubic in the
+input in the worst case, quadratic for unambiguous grammars and linear for
+deterministic ones. Lexical productions are matched by a nested parse, which
+is linear in their longest match.
+
+Built-ins are those of emit_recognizer(), with letter, lower, upper, digit and
+alphanum matching code points of their Unicode classes like u_letter() and the
+like, and character matching any code point other than a quote mark.
+
+The parser returns the longest prefix of the input that the start production
+matches, and consumes the whitespace after it unless the start production is
+lexical. Where the input can be parsed in more than one way, earlier
+alternatives are preferred, optional parts are taken and the parts of a
+sequence match as much as they can from the left, like a greedy parser that
+tries alternatives in order. Steps are counted as in
+parsing.h, one per Earley item, so a parse can be bounded by bounded_parse().
+
+The constructor throws std::invalid_argument if start or an identifier in the
+grammar is not defined. Inputs are limited to 4 GB.
+*/
+class Earley_parser
+{
+public:
+
+    Earley_parser(Ast const& syntax, std::string_view start, Earley_options const& options = {});
+
+    auto operator()(std::string_view input) const -> Parsed_t<Parse_node>;
+
+    struct Grammar;
+
+private:
+
+    std::shared_ptr<Grammar const> grammar_;
+};
+
+// The self-describing grammar that earley_syntax() parses with, with literals
+// that double the quote mark inside them as syntax() reads them.
+inline constexpr std::string_view earley_self_grammar =
+    "syntax = {production}.\n"
+    "production = identifier \"=\" expression \".\".\n"
+    "expression = term {\"|\" term}.\n"
+    "term = factor {factor}.\n"
+    "factor = identifier | literal | \"(\" expression \")\" | \"[\" expression \"]\" | \"{\" expression \"}\".\n"
+    "literal = \"\"\"\" (character | \"\"\"\"\"\") {character | \"\"\"\"\"\"} \"\"\"\".\n"
+    "identifier = (letter | \"_\") {letter | \"_\" | digit}.\n";
+
+// syntax = {production}, parsed with an Earley_parser for the self-describing
+// grammar. Builds the same tree as syntax() for any input that syntax() parses.
+auto earley_syntax(std::string_view input) -> Parsed_t<Ast>;
@@ -0,0 +1,116 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+#include "parsing.h"
+
+/*
+Event-stream parse output.
+
+parse_events() recognizes a grammar like syntax() but builds no tree. Instead
+it calls a Parse_handler in parse order: enter and exit for each syntax,
+production, expression, term and factor, and the source spans of identifiers
+and literals. The default handler does nothing, so parse_events() with a plain
+Parse_handler validates a grammar, allocating only a buffer for the events of
+one production. Its memory is thus linear in the longest production, not
+constant, and does not grow with the number of productions.
+
+parse_events() accepts the same grammars as syntax() and stops at the same
+place. The events of a production are passed on once it has matched, so a
+handler never sees an abandoned alternative. If the parse fails, the events
+received so far describe a prefix of the input and should be discarded.
+*/
+class Parse_handler
+{
+public:
+
+    virtual ~Parse_handler() = default;
+
+    virtual void enter_syntax() {}
+    virtual void exit_syntax() {}
+
+    virtual void enter_production() {}
+    virtual void exit_production() {}
+
+    virtual void enter_expression() {}
+    virtual void exit_expression() {}
+
+    virtual void enter_term() {}
+    virtual void exit_term() {}
+
+    virtual void enter_factor(Factor::Type) {}
+    virtual void exit_factor(Factor::Type) {}
+
+    // The name of a production, or of an identifier factor.
+    virtual void identifier(std::string_view) {}
+
+    // The text between the quotes of a literal, with quotes still doubled.
+    virtual void literal(std::string_view) {}
+};
+
+// Returns the input that is left after the last production, like syntax().
+auto parse_events(std::string_view input, Parse_handler& handler) -> Parsed_t<Unit>;
+
+// Builds the same tree as syntax() from the events.
+class Ast_builder : public Parse_handler
+{
+public:
+
+    void enter_syntax() override;
+    void exit_syntax() override;
+
+    void enter_production() override;
+    void exit_production() override;
+
+    void enter_expression() override;
+    void exit_expression() override;
+
+    void enter_term() override;
+    void exit_term() override;
+
+    void enter_factor(Factor::Type type) override;
+    void exit_factor(Factor::Type type) override;
+
+    void identifier(std::string_view value) override;
+
+    void literal(std::string_view value) override;
+
+    // The tree, once the syntax has been exited.
+    std::optional<Ast> const& result() const;
+
+private:
+
+    // The finished children of each node that has been entered but not exited.
+    std::vector<std::vector<Ast>> open_;
+    std::optional<Ast> result_;
+};
@@ -0,0 +1,76 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include "ast.h"
+
+struct Generator_options
+{
+    // Sentences of the start production are written until this many bytes
+    // have been written. The last sentence is always completed.
+    std::size_t size = 1 << 20;
+
+    std::uint64_t seed = 0;
+
+    // Below this nesting depth of expressions, alternatives are picked at
+    // random. Beyond it, the alternative that ends soonest is picked, and
+    // optional and repeated factors are left out.
+    std::size_t max_depth = 16;
+
+    std::size_t min_repeat = 0;
+    std::size_t max_repeat = 3;
+
+    double optional_probability = 0.5;
+
+    // Productions that describe tokens. Factors inside them are written
+    // without a separator in between.
+    std::set<std::string, std::less<>> lexical;
+
+    std::string separator = " ";
+};
+
+/*
+Writes random sentences described by a Syntax Ast to out. The output depends
+only on the grammar and the options, so a seed reproduces an input exactly.
+Memory use does not depend on options.size, only on max_depth.
+
+Besides its own productions, a grammar can use the identifiers letter, lower,
+upper, digit, alphanum, character and newline, which produce a single
+character. character produces printable ASCII other than a quote mark.
+
+Returns false if start or an identifier it depends on is not defined, or if a
+production that start can reach cannot derive a finite sentence.
+*/
+bool generate(Ast const& syntax, std::string_view start, Generator_options const& options, std::ostream& out);
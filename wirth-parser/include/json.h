@@ -0,0 +1,51 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Returns st as a quoted JSON string, for the tools that print their results as JSON.
+inline std::string json_string(std::string_view st)
+{
+    std::string ret = "\"";
+    for (auto const ch : st) {
+        if (ch == '"' || ch == '\\') {
+            ret += '\\';
+            ret += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            constexpr std::string_view digits{"0123456789abcdef"};
+            ret += "\\u00";
+            ret += digits[static_cast<unsigned char>(ch) >> 4];
+            ret += digits[static_cast<unsigned char>(ch) & 0xf];
+        } else {
+            ret += ch;
+        }
+    }
+    return ret + '"';
+}
@@ -29,14 +29,16 @@ For more information, please refer to <http://unlicense.org>
 
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "parsing.h"
+#include "utf8.h"
 
 template <typename T>
-auto appended_vector(std::vector<T> x, T const& y) -> std::vector<T>
+auto appended_vector(std::vector<T> x, T y) -> std::vector<T>
 {
-    x.push_back(y);
+    x.push_back(std::move(y));
     return x;
 }
 
@@ -48,16 +50,43 @@ Parser auto repeat(P parser)
     return reduce_many(
         Ts{},
         parser,
-        [](Ts const& ts, T const& t){ return appended_vector(ts, t); }
+        [](Ts ts, T t){ return appended_vector(std::move(ts), std::move(t)); }
     );
 }
 
+// The source text of an identifier, and of the inside of a literal with its
+// quotes still doubled, recognized without building their values.
+inline constexpr Parser auto identifier_span = consumed(
+    skip_sequence(
+        choice(u_letter, u_symbol('_')),
+        skip_many(choice(u_letter, u_symbol('_'), u_digit))
+    )
+);
+
+inline constexpr Parser auto literal_span = consumed(
+    skip_some(
+        choice(
+            skip_sequence(symbol('"'), symbol('"')),
+            skip_sequence(satisfy([](char x){ return x != '"'; }))
+        )
+    )
+);
+
 class Ast;
 
 auto foo(std::string_view input) -> Parsed_t<Ast>;
 
 auto syntax(std::string_view input) -> Parsed_t<Ast>;
 
+// Like syntax(), but only the identifier of each production is parsed up
+// front. Its expression is a Lazy node over the source text of the body, which
+// is parsed on first access and throws std::invalid_argument if it is not a
+// valid expression. The input must outlive the tree.
+auto lazy_syntax(std::string_view input) -> Parsed_t<Ast>;
+
+// The parsers below each production start at a token and consume the trivia
+// after their last token, so only syntax() skips leading whitespace.
+// A failure after a commit() inside them is returned as a failed parse.
 auto production(std::string_view input) -> Parsed_t<Ast>;
 
 auto expression(std::string_view input) -> Parsed_t<Ast>;
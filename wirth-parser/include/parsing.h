@@ -27,34 +27,105 @@ For more information, please refer to <http://unlicense.org>
 
 #pragma once
 
+#include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <concepts>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <stop_token>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 // Basic definitions
+//
+// Parsers take their input by value and return what is left of it. The input
+// is a std::string_view unless a parser says otherwise by taking another view
+// of a forward range, such as a std::span of tokens.
 
-template <typename T>
-using Parsed_t = std::optional<std::pair<T, std::string_view>>;
+template <typename T, typename I = std::string_view>
+using Parsed_t = std::optional<std::pair<T, I>>;
+
+// The input type of a parser, read off the parameter of its call operator.
+// Parsers with a generic call operator, like unit(), work on any input and
+// count as string_view parsers on their own.
+template <typename P>
+struct Parser_input
+{
+    using type = std::string_view;
+};
 
 template <typename P>
+requires requires { &P::operator(); }
+struct Parser_input<P> : Parser_input<decltype(&P::operator())> {};
+
+template <typename R, typename I>
+struct Parser_input<R (*)(I)>
+{
+    using type = std::remove_cvref_t<I>;
+};
+
+template <typename R, typename C, typename I>
+struct Parser_input<R (C::*)(I) const>
+{
+    using type = std::remove_cvref_t<I>;
+};
+
+template <typename R, typename C, typename I>
+struct Parser_input<R (C::*)(I)>
+{
+    using type = std::remove_cvref_t<I>;
+};
+
+template <typename P>
+using Parser_input_t = typename Parser_input<std::remove_cvref_t<P>>::type;
+
+// The input type of a combination of parsers: the first one that is not
+// string_view, so generic parsers take on the input of the others.
+template <typename... Ps>
+struct Common_input
+{
+    using type = std::string_view;
+};
+
+template <typename P, typename... Ps>
+struct Common_input<P, Ps...>
+{
+    using type = std::conditional_t<
+        std::same_as<Parser_input_t<P>, std::string_view>,
+        typename Common_input<Ps...>::type,
+        Parser_input_t<P>>;
+};
+
+template <typename... Ps>
+using Common_input_t = typename Common_input<Ps...>::type;
+
+template <typename P, typename I = Parser_input_t<P>>
 concept Parser =
-    std::regular_invocable<P, std::string_view> &&
-    requires (std::invoke_result_t<P, std::string_view> result) {
-        std::same_as<
+    std::regular_invocable<P, I> &&
+    requires (std::invoke_result_t<P, I> result) {
+        requires std::same_as<
             decltype(result),
-            Parsed_t<typename decltype(result)::value_type::first_type>>;
+            Parsed_t<typename decltype(result)::value_type::first_type, I>>;
     };
 
-template <Parser P>
-using Parser_result_t = std::invoke_result_t<P, std::string_view>;
+template <typename P, typename I = Parser_input_t<P>>
+requires Parser<P, I>
+using Parser_result_t = std::invoke_result_t<P, I>;
 
-template <Parser P>
-using Parser_value_t = typename Parser_result_t<P>::value_type::first_type;
+template <typename P, typename I = Parser_input_t<P>>
+requires Parser<P, I>
+using Parser_value_t = typename Parser_result_t<P, I>::value_type::first_type;
 
 template <typename F, typename... Args>
 concept Parser_combinator =
@@ -65,23 +136,177 @@ template <typename F, typename... Args>
 requires Parser_combinator<F, Args...>
 using Parser_combinator_value_t = std::invoke_result_t<F, Args...>;
 
+// Step counting and budgets
+//
+// The core parsers count a step in a per-thread counter for each element,
+// literal or code point they read, each alternative they try and each
+// repetition they make. The count measures parse work independently of the
+// machine, so inputs that make a parser backtrack excessively can be found
+// from it, and it bounds the work of a parse run by bounded_parse().
+
+inline constinit thread_local std::uint64_t parse_steps = 0;
+
+// A limit on the work of a parse: a number of steps, an optional deadline, and
+// a token through which another thread can cancel the parse.
+struct Parse_budget
+{
+    std::uint64_t steps = UINT64_MAX;
+    std::optional<std::chrono::steady_clock::time_point> deadline = {};
+    std::stop_token stop = {};
+};
+
+class Budget_exhausted : public std::runtime_error
+{
+public:
+
+    enum class Reason { steps, deadline, cancelled };
+
+    explicit
+    Budget_exhausted(Reason reason)
+        : std::runtime_error{"parser exhausted its budget"}, reason_{reason}
+    {}
+
+    auto
+    reason() const -> Reason
+    {
+        return reason_;
+    }
+
+private:
+
+    Reason reason_;
+};
+
+// A bounded parse in progress, with the earliest deadline of its budget and the
+// budgets of the bounded parses it runs in, and whether any of them has a
+// deadline or a stop token to poll.
+struct Budget_scope
+{
+    Parse_budget const* budget;
+    Budget_scope const* outer;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    bool polled;
+};
+
+// The innermost bounded parse on this thread, the step count at which it runs
+// out, and the step count at which count_step() next checks it.
+inline constinit thread_local Budget_scope const* parse_budget = nullptr;
+inline constinit thread_local std::uint64_t parse_step_end = UINT64_MAX;
+inline constinit thread_local std::uint64_t parse_checkpoint = UINT64_MAX;
+
+// Steps between checks of the deadline and the stop tokens.
+inline constexpr std::uint64_t budget_check_interval = 1024;
+
+// Whether a bounded parse, or one it runs in, has been cancelled or is past its
+// deadline.
+inline auto
+budget_exhausted(Budget_scope const* scope) -> std::optional<Budget_exhausted::Reason>
+{
+    using enum Budget_exhausted::Reason;
+    for (auto const* x = scope; x; x = x->outer) {
+        if (x->budget->stop.stop_requested()) return cancelled;
+    }
+    if (scope && scope->deadline && std::chrono::steady_clock::now() >= *scope->deadline) return deadline;
+    return {};
+}
+
+[[gnu::cold]] inline void
+check_budget()
+{
+    using enum Budget_exhausted::Reason;
+    if (parse_steps > parse_step_end) {
+        throw Budget_exhausted{steps};
+    } else if (auto const reason = budget_exhausted(parse_budget)) {
+        throw Budget_exhausted{*reason};
+    }
+    parse_checkpoint = std::min(parse_step_end, parse_steps + budget_check_interval);
+}
+
+constexpr void
+count_step()
+{
+    if (!std::is_constant_evaluated() && ++parse_steps > parse_checkpoint) {
+        check_budget();
+    }
+}
+
+// The result of a bounded parse, which is either the result of the parser or
+// the reason the parse was abandoned, with the number of steps it took.
+template <typename T, typename I = std::string_view>
+struct Bounded_result
+{
+    Parsed_t<T, I> parsed;
+    std::optional<Budget_exhausted::Reason> exhausted;
+    std::uint64_t steps;
+};
+
+// Runs a parser on an input within a budget. A parse that runs out of budget
+// is abandoned at its next step, and reports why in exhausted instead of
+// failing. A bounded parse within another one is also bounded by the steps
+// left in the outer one, its deadline and its stop token, and running out of
+// those abandons the outer one.
+template <Parser P, typename I = Parser_input_t<P>>
+auto
+bounded_parse(P parser, I input, Parse_budget const& budget) -> Bounded_result<Parser_value_t<P, I>, I>
+{
+    struct Scope
+    {
+        Budget_scope const* budget = parse_budget;
+        std::uint64_t step_end = parse_step_end;
+        std::uint64_t checkpoint = parse_checkpoint;
+
+        ~Scope()
+        {
+            parse_budget = budget;
+            parse_step_end = step_end;
+            parse_checkpoint = checkpoint;
+        }
+    } const outer;
+
+    auto deadline = budget.deadline;
+    if (outer.budget && outer.budget->deadline && (!deadline || *outer.budget->deadline < *deadline)) {
+        deadline = outer.budget->deadline;
+    }
+    Budget_scope const scope{&budget, outer.budget, deadline, deadline || budget.stop.stop_possible() || (outer.budget && outer.budget->polled)};
+
+    auto const start = parse_steps;
+    parse_budget = &scope;
+    parse_step_end = std::min(outer.step_end, budget.steps > UINT64_MAX - start ? UINT64_MAX : start + budget.steps);
+    parse_checkpoint = scope.polled ? start : parse_step_end;
+    try {
+        auto parsed = std::invoke(parser, input);
+        return {std::move(parsed), {}, parse_steps - start};
+    } catch (Budget_exhausted const& e) {
+        if (parse_steps > outer.step_end || budget_exhausted(outer.budget)) throw;
+        return {{}, e.reason(), parse_steps - start};
+    }
+}
+
+// Parses one element of any input that is a view of a forward range.
+template <std::ranges::forward_range I>
+requires std::ranges::view<I> && std::constructible_from<I, std::ranges::iterator_t<I>, std::ranges::sentinel_t<I>>
 inline constexpr auto
-item = [](std::string_view input) -> Parsed_t<char>
+item_of = [](I input) -> Parsed_t<std::ranges::range_value_t<I>, I>
 {
-    if (input.empty()) {
+    count_step();
+    if (std::ranges::empty(input)) {
         return {};
     } else {
-        return {{input[0], input.substr(1)}};
+        auto const first = std::ranges::begin(input);
+        return {{*first, I{std::ranges::next(first), std::ranges::end(input)}}};
     }
 };
 
+inline constexpr auto
+item = item_of<std::string_view>;
+
 // Sequencing parsers
 
 template <typename T>
 constexpr Parser auto
 unit(T const& thing)
 {
-    return [thing](std::string_view input) -> Parsed_t<T>
+    return [thing]<typename I>(I input) -> Parsed_t<T, I>
     {
         return {{thing, input}};
     };
@@ -91,11 +316,13 @@ template <Parser P, Parser_combinator<Parser_value_t<P>> F>
 constexpr Parser auto
 operator&(P parser, F func)
 {
+    using I = Parser_input_t<P>;
     using Parser_t = Parser_combinator_value_t<F, Parser_value_t<P>>;
-    return [=](std::string_view input) -> Parser_result_t<Parser_t>
+    return [=](I input) -> Parser_result_t<Parser_t, I>
     {
-        if (auto const& result = std::invoke(parser, input)) {
-            return std::invoke(std::invoke(func, result->first), result->second);
+        count_step();
+        if (auto result = std::invoke(parser, input)) {
+            return std::invoke(std::invoke(func, std::move(result->first)), result->second);
         } else {
             return {};
         }
@@ -106,7 +333,8 @@ constexpr Parser auto
 chain(Parser auto parser, auto... funcs)
 {
     if constexpr (std::is_pointer_v<decltype(parser)>) {
-        return ([parser](auto input){ return std::invoke(parser, input); } & ... & funcs);
+        using I = Parser_input_t<decltype(parser)>;
+        return ([parser](I input){ return std::invoke(parser, input); } & ... & funcs);
     } else {
         return (parser & ... & funcs);
     }
@@ -139,12 +367,13 @@ template <Parser P, Parser Q>
 constexpr Parser auto
 operator^(P p, Q q)
 {
-    using Result_t = std::invoke_result_t<decltype(papply), Parser_value_t<P>, Parser_value_t<Q>>;
-    return [=](std::string_view input) -> Parsed_t<Result_t>
+    using I = Common_input_t<P, Q>;
+    using Result_t = std::invoke_result_t<decltype(papply), Parser_value_t<P, I>, Parser_value_t<Q, I>>;
+    return [=](I input) -> Parsed_t<Result_t, I>
     {
-        if (auto const& pr = std::invoke(p, input)) {
-            if (auto const& qr = std::invoke(q, pr->second)) {
-                return {{papply(pr->first, qr->first), qr->second}};
+        if (auto pr = std::invoke(p, input)) {
+            if (auto qr = std::invoke(q, pr->second)) {
+                return {{papply(std::move(pr->first), std::move(qr->first)), qr->second}};
             } else {
                 return {};
             }
@@ -154,12 +383,51 @@ operator^(P p, Q q)
     };
 }
 
+// An n-ary sequence holds its parsers in a flat tuple instead of a fold of
+// operator^ closures. Each parsed value is passed on to the next step by
+// reference, and func is called once with all of them at the end.
+template <typename F, Parser... Ps>
+requires std::regular_invocable<F, Parser_value_t<Ps, Common_input_t<Ps...>>...>
+class Sequence
+{
+    [[no_unique_address]] F func; std::tuple<Ps...> parsers;
+
+    using Input_t = Common_input_t<Ps...>;
+    using Result_t = std::invoke_result_t<F, Parser_value_t<Ps, Input_t>...>;
+
+    template <std::size_t I, typename... Ts>
+    constexpr auto
+    step(Input_t input, Ts&&... values) const -> Parsed_t<Result_t, Input_t>
+    {
+        if constexpr (I == sizeof...(Ps)) {
+            return {{std::invoke(func, std::forward<Ts>(values)...), input}};
+        } else if (auto result = std::invoke(std::get<I>(parsers), input)) {
+            return step<I + 1>(result->second, std::forward<Ts>(values)..., std::move(result->first));
+        } else {
+            return {};
+        }
+    }
+
+public:
+
+    constexpr explicit
+    Sequence(F const& fn, Ps const&... ps)
+        : func{fn}, parsers{ps...}
+    {}
+
+    constexpr auto
+    operator()(Input_t input) const -> Parsed_t<Result_t, Input_t>
+    {
+        return step<0>(input);
+    }
+};
+
 template <typename F, Parser... Ps>
-requires std::regular_invocable<F, Parser_value_t<Ps>...>
+requires std::regular_invocable<F, Parser_value_t<Ps, Common_input_t<Ps...>>...>
 constexpr Parser auto
 sequence(F func, Ps... parsers)
 {
-    return (unit(func) ^ ... ^ parsers);
+    return Sequence<F, Ps...>{func, parsers...};
 }
 
 template <typename T, Parser P, std::regular_invocable<T, Parser_value_t<P>> F>
@@ -175,19 +443,18 @@ public:
         : init{thing}, parser{p}, func{fn}
     {}
 
+    // Folds the values in a loop, moving the accumulated value through func
+    // instead of copying it into a new reduce_many for every item.
     constexpr auto
-    operator()(std::string_view input) const -> Parsed_t<T>
+    operator()(Parser_input_t<P> input) const -> Parsed_t<T, Parser_input_t<P>>
     {
-        return choice(
-            chain(
-                parser,
-                [this](auto const& thing)
-                {
-                    return reduce_many{std::invoke(func, init, thing), parser, func};
-                }
-            ),
-            unit(init)
-        )(input);
+        T acc = init;
+        while (auto result = std::invoke(parser, input)) {
+            count_step();
+            acc = std::invoke(func, std::move(acc), std::move(result->first));
+            input = result->second;
+        }
+        return {{std::move(acc), input}};
     }
 };
 
@@ -199,7 +466,7 @@ many(P parser)
     return reduce_many(
         std::string{},
         parser,
-        [](std::string const& st, char ch){ return st + ch; }
+        [](std::string st, char ch){ st += ch; return st; }
     );
 }
 
@@ -209,7 +476,7 @@ constexpr Parser auto
 some(P parser)
 {
     return sequence(
-        [](char ch, std::string const& st){ return std::string(1, ch) + st; },
+        [](char ch, std::string st){ st.insert(st.begin(), ch); return st; },
         parser,
         many(parser)
     );
@@ -217,21 +484,23 @@ some(P parser)
 
 // Making choices
 
-template <typename T>
+template <typename T, typename I = std::string_view>
 inline constexpr auto
-empty = [](std::string_view) -> Parsed_t<T>
+empty = [](I) -> Parsed_t<T, I>
 {
     return {};
 };
 
 template <Parser P, Parser Q>
-requires std::convertible_to<Parser_value_t<P>, Parser_value_t<Q>>
+requires std::convertible_to<Parser_value_t<P, Common_input_t<P, Q>>, Parser_value_t<Q, Common_input_t<P, Q>>>
 constexpr Parser auto
 operator|(P p, Q q)
 {
-    return [=](std::string_view input) -> Parser_result_t<Q>
+    using I = Common_input_t<P, Q>;
+    return [=](I input) -> Parser_result_t<Q, I>
     {
-        if (auto const& result = std::invoke(p, input)) {
+        count_step();
+        if (auto result = std::invoke(p, input)) {
             return result;
         } else {
             return std::invoke(q, input);
@@ -239,14 +508,55 @@ operator|(P p, Q q)
     };
 }
 
-constexpr Parser auto
-choice(Parser auto parser, Parser auto... parsers)
+// An n-ary choice tries its parsers in order from a flat tuple. Like a fold of
+// operator|, the result has the type of the last alternative.
+template <Parser... Ps>
+class Choice
 {
-    if constexpr (std::is_pointer_v<decltype(parser)>) {
-        return ([parser](auto input){ return std::invoke(parser, input); } | ... | parsers);
-    } else {
-        return (parser | ... | parsers);
+    std::tuple<Ps...> parsers;
+
+    using Input_t = Common_input_t<Ps...>;
+    using Result_t = Parser_result_t<std::tuple_element_t<sizeof...(Ps) - 1, std::tuple<Ps...>>, Input_t>;
+
+    template <std::size_t I = 0>
+    constexpr auto
+    attempt(Input_t input) const -> Result_t
+    {
+        count_step();
+        auto result = std::invoke(std::get<I>(parsers), input);
+        if constexpr (I + 1 == sizeof...(Ps)) {
+            return result;
+        } else if (!result) {
+            return attempt<I + 1>(input);
+        } else if constexpr (std::same_as<decltype(result), Result_t>) {
+            return result;
+        } else {
+            return {{std::move(result->first), result->second}};
+        }
     }
+
+public:
+
+    constexpr explicit
+    Choice(Ps const&... ps)
+        : parsers{ps...}
+    {}
+
+    constexpr auto
+    operator()(Input_t input) const -> Result_t
+    {
+        return attempt(input);
+    }
+};
+
+template <Parser P, Parser... Ps>
+requires
+    std::convertible_to<Parser_value_t<P, Common_input_t<P, Ps...>>, Parser_value_t<Choice<P, Ps...>>> &&
+    (std::convertible_to<Parser_value_t<Ps, Common_input_t<P, Ps...>>, Parser_value_t<Choice<P, Ps...>>> && ...)
+constexpr Parser auto
+choice(P parser, Ps... parsers)
+{
+    return Choice<P, Ps...>{parser, parsers...};
 }
 
 static_assert(
@@ -258,7 +568,8 @@ template <Parser P, Parser Q>
 constexpr Parser auto
 pass_empty(P p, Q q)
 {
-    return [=](std::string_view input) -> Parser_result_t<Q>
+    using I = Common_input_t<P, Q>;
+    return [=](I input) -> Parser_result_t<Q, I>
     {
         if (auto const& result = std::invoke(p, input)) {
             return {};
@@ -268,6 +579,63 @@ pass_empty(P p, Q q)
     };
 }
 
+// Committing
+//
+// Once the parsers before a commit() have matched, no other alternative of an
+// enclosing choice can match either, so a failure of the committed parser is
+// thrown past them instead of making each of them rescan the input. try_parse()
+// turns it back into an ordinary failure at the entry points of a grammar.
+
+class Committed_failure : public std::runtime_error
+{
+    std::string_view where_;
+
+public:
+
+    explicit
+    Committed_failure(std::string_view where)
+        : std::runtime_error{"parser failed after a commit"}, where_{where}
+    {}
+
+    // The input the committed parser failed on, or an empty view for a parser
+    // over input other than characters.
+    auto
+    where() const -> std::string_view
+    {
+        return where_;
+    }
+};
+
+template <Parser P>
+constexpr Parser auto
+commit(P parser)
+{
+    return [parser](Parser_input_t<P> input) -> Parser_result_t<P>
+    {
+        if (auto result = std::invoke(parser, input)) {
+            return result;
+        } else if constexpr (std::same_as<Parser_input_t<P>, std::string_view>) {
+            throw Committed_failure{input};
+        } else {
+            throw Committed_failure{{}};
+        }
+    };
+}
+
+template <Parser P>
+constexpr Parser auto
+try_parse(P parser)
+{
+    return [parser](Parser_input_t<P> input) -> Parser_result_t<P>
+    {
+        try {
+            return std::invoke(parser, input);
+        } catch (Committed_failure const&) {
+            return {};
+        }
+    };
+}
+
 // Derived primitives
 
 constexpr Parser auto
@@ -281,28 +649,28 @@ requires std::predicate<Pr, Parser_value_t<P>>
 constexpr Parser auto
 satisfy(Pr pred, P parser = item)
 {
-    return chain(
-        parser,
-        [pred](auto const& th) -> Parser auto
-        {
-            return [pred, th](std::string_view input) -> Parsed_t<Parser_value_t<P>>
-            {
-                if (std::invoke(pred, th)) return {{th, input}}; else return {};
-            };
+    return [pred, parser](Parser_input_t<P> input) -> Parser_result_t<P>
+    {
+        if (auto result = std::invoke(parser, input); result && std::invoke(pred, result->first)) {
+            return result;
+        } else {
+            return {};
         }
-    );
+    };
 }
 
 template <Parser P>
 constexpr Parser auto
 maybe(P parser)
 {
-    return [parser](std::string_view input) -> Parsed_t<std::optional<Parser_value_t<P>>>
+    using I = Parser_input_t<P>;
+    return [parser](I input) -> Parsed_t<std::optional<Parser_value_t<P>>, I>
     {
-        return choice(
-            chain(parser, [](auto const& thing){ return unit(std::optional{thing}); }),
-            unit(std::optional<Parser_value_t<P>>{})
-        )(input);
+        if (auto result = std::invoke(parser, input)) {
+            return {{std::move(result->first), result->second}};
+        } else {
+            return {{std::nullopt, input}};
+        }
     };
 }
 
@@ -332,6 +700,7 @@ str(std::string_view match)
 {
     return [match](std::string_view input) -> Parsed_t<std::string>
     {
+        count_step();
         if (input.starts_with(match)) {
             return {{
                 std::string{match}, {input.begin() + match.size(), input.end()}
@@ -343,12 +712,219 @@ str(std::string_view match)
 }
 static_assert(Parser_combinator<decltype(str), std::string_view>);
 
+// A trie over a set of literals, built once when a parser is constructed.
+// match() walks the input once and returns the index of the longest literal
+// that is a prefix of it, where choice(str(...), ...) would try each literal
+// in turn and return the first one that matches.
+class Literal_trie
+{
+    struct Edge
+    {
+        char label;
+        std::uint32_t target;
+    };
+
+    struct Node
+    {
+        std::uint32_t first = 0;
+        std::uint32_t count = 0;
+        std::optional<std::size_t> match;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+
+public:
+
+    explicit
+    Literal_trie(std::initializer_list<std::string_view> matches)
+        : Literal_trie{std::vector<std::string_view>(matches)}
+    {}
+
+    template <std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_value_t<R>, std::string_view>
+    explicit
+    Literal_trie(R const& matches)
+    {
+        std::vector<std::map<char, std::uint32_t>> children(1);
+        std::vector<std::optional<std::size_t>> found(1);
+        std::size_t index = 0;
+        for (std::string_view const match : matches) {
+            std::uint32_t at = 0;
+            for (auto const ch : match) {
+                auto [it, inserted] = children[at].try_emplace(ch, static_cast<std::uint32_t>(children.size()));
+                at = it->second;
+                if (inserted) {
+                    children.emplace_back();
+                    found.emplace_back();
+                }
+            }
+            if (!found[at]) found[at] = index;
+            ++index;
+        }
+
+        nodes.resize(children.size());
+        for (std::size_t i = 0; i != children.size(); ++i) {
+            nodes[i] = {static_cast<std::uint32_t>(edges.size()), static_cast<std::uint32_t>(children[i].size()), found[i]};
+            for (auto const& [label, target] : children[i]) {
+                edges.push_back({label, target});
+            }
+        }
+    }
+
+    auto
+    match(std::string_view input) const -> Parsed_t<std::size_t>
+    {
+        count_step();
+        Parsed_t<std::size_t> longest;
+        std::uint32_t at = 0;
+        for (std::size_t i = 0;; ++i) {
+            if (auto const& node = nodes[at]; node.match) {
+                longest = {{*node.match, input.substr(i)}};
+            }
+            if (i == input.size()) break;
+
+            auto const& node = nodes[at];
+            auto const first = edges.begin() + node.first;
+            auto const edge = std::find_if(
+                first, first + node.count, [ch = input[i]](Edge const& e){ return e.label == ch; }
+            );
+            if (edge == first + node.count) break;
+            at = edge->target;
+        }
+        return longest;
+    }
+};
+
+// Matches the longest of a set of literals and returns its index in the set.
+inline Parser auto
+one_of(std::initializer_list<std::string_view> matches)
+{
+    return [trie = std::make_shared<Literal_trie const>(matches)](std::string_view input)
+    {
+        return trie->match(input);
+    };
+}
+
+// Matches the longest of a set of literals and returns it, like a choice of str parsers.
+inline Parser auto
+literals(std::initializer_list<std::string_view> matches)
+{
+    std::vector<std::string> texts(matches.begin(), matches.end());
+    return chain(
+        one_of(matches),
+        [texts = std::make_shared<std::vector<std::string> const>(std::move(texts))](std::size_t i)
+        {
+            return unit((*texts)[i]);
+        }
+    );
+}
+
+// Recognizers
+//
+// These only advance the input. Their value is Unit, so nothing is built for
+// parts of the input whose values would be thrown away.
+
+struct Unit
+{
+    friend constexpr bool operator==(Unit, Unit) = default;
+};
+
+template <Parser P>
+constexpr Parser auto
+skip_many(P parser)
+{
+    using I = Parser_input_t<P>;
+    return [parser](I input) -> Parsed_t<Unit, I>
+    {
+        while (auto result = std::invoke(parser, input)) {
+            count_step();
+            input = result->second;
+        }
+        return {{Unit{}, input}};
+    };
+}
+
+template <Parser P>
+constexpr Parser auto
+skip_some(P parser)
+{
+    using I = Parser_input_t<P>;
+    return [parser](I input) -> Parsed_t<Unit, I>
+    {
+        if (auto result = std::invoke(parser, input)) {
+            return std::invoke(skip_many(parser), result->second);
+        } else {
+            return {};
+        }
+    };
+}
+
+template <Parser P>
+constexpr Parser auto
+skip_maybe(P parser)
+{
+    using I = Parser_input_t<P>;
+    return [parser](I input) -> Parsed_t<Unit, I>
+    {
+        if (auto result = std::invoke(parser, input)) {
+            return {{Unit{}, result->second}};
+        } else {
+            return {{Unit{}, input}};
+        }
+    };
+}
+
+template <Parser... Ps>
+constexpr Parser auto
+skip_sequence(Ps... parsers)
+{
+    return sequence([](auto&&...){ return Unit{}; }, parsers...);
+}
+
+constexpr Parser auto
+skip_str(std::string_view match)
+{
+    return [match](std::string_view input) -> Parsed_t<Unit>
+    {
+        count_step();
+        if (input.starts_with(match)) {
+            return {{Unit{}, input.substr(match.size())}};
+        } else {
+            return {};
+        }
+    };
+}
+
+// Returns the input that a parser consumed instead of its value.
+template <Parser P>
+constexpr Parser auto
+consumed(P parser)
+{
+    return [parser](std::string_view input) -> Parsed_t<std::string_view>
+    {
+        if (auto result = std::invoke(parser, input)) {
+            return {{input.substr(0, input.size() - result->second.size()), result->second}};
+        } else {
+            return {};
+        }
+    };
+}
+
+static_assert(
+    skip_sequence(skip_many(symbol('x')), skip_some(symbol('y')), skip_maybe(symbol('z')))("xxyw") ==
+    Parsed_t<Unit>{{Unit{}, "w"}},
+    "recognizers must advance the input like the parsers they replace"
+);
+
 //  Handling spacing
 
 inline constexpr Parser auto space = satisfy(::isspace);
 
 inline Parser auto whitespace = many(space);
 
+inline constexpr Parser auto skip_whitespace = skip_many(space);
+
 inline Parser auto eol = choice(str("\r\n"), str("\r"), str("\n"));
 
 inline Parser auto separator = choice(eol, sequence([](auto ch){ return std::string(1, ch); }, space));
@@ -357,8 +933,152 @@ constexpr Parser auto
 token(Parser auto parser)
 {
     return sequence(
-        [](auto const& thing, auto){ return thing; },
-        skip(whitespace, parser),
-        whitespace
+        [](auto thing, auto){ return thing; },
+        skip(skip_whitespace, parser),
+        skip_whitespace
     );
 }
+
+constexpr Parser auto
+skip_token(Parser auto parser)
+{
+    return skip_sequence(skip(skip_whitespace, parser), skip_whitespace);
+}
+
+// Lexemes parse a token at the start of the input and then the trivia after
+// it, which for now is whitespace. Each stretch of trivia is consumed once, by
+// the token before it, where token() probes it again for the token after it
+// and runs the parser a second time when that fails. The trivia before the
+// first token is skipped once at the start of a parse.
+
+inline constexpr Parser auto trivia = skip_whitespace;
+
+// A token's value and the trivia after it, which starts where the token ends.
+template <typename T>
+struct Lexeme
+{
+    T value;
+    std::string_view trivia;
+};
+
+template <Parser P>
+constexpr Parser auto
+lexeme(P parser)
+{
+    return [parser](std::string_view input) -> Parser_result_t<P>
+    {
+        auto result = std::invoke(parser, input);
+        if (result) result->second = std::invoke(trivia, result->second)->second;
+        return result;
+    };
+}
+
+constexpr Parser auto
+skip_lexeme(Parser auto parser)
+{
+    return skip_sequence(parser, trivia);
+}
+
+template <Parser P>
+constexpr Parser auto
+with_trivia(P parser)
+{
+    return [parser](std::string_view input) -> Parsed_t<Lexeme<Parser_value_t<P>>>
+    {
+        if (auto result = std::invoke(parser, input)) {
+            auto const after = result->second;
+            auto const rest = std::invoke(trivia, after)->second;
+            return {{{std::move(result->first), after.substr(0, after.size() - rest.size())}, rest}};
+        } else {
+            return {};
+        }
+    };
+}
+
+// Operator precedence
+
+enum class Associativity { left, right };
+
+template <typename T>
+struct Binary_operator
+{
+    std::string_view token;
+    int precedence;
+    Associativity associativity;
+    T (*fold)(T, T);
+};
+
+// Parses atoms separated by the binary operators in a table, where a grammar
+// would need one production per precedence level. The operators are matched
+// as tokens, longest first, and the expression is folded in a single loop
+// with explicit stacks of operands and pending operators. Like atom {op atom},
+// an operator that is not followed by an atom is left in the input.
+template <Parser P>
+Parser auto
+operators(std::initializer_list<Binary_operator<Parser_value_t<P>>> table, P atom)
+{
+    using T = Parser_value_t<P>;
+    using Table = std::vector<Binary_operator<T>>;
+
+    auto ops = std::make_shared<Table const>(table);
+    std::vector<std::string_view> tokens;
+    for (auto const& op : *ops) {
+        tokens.push_back(op.token);
+    }
+    auto trie = std::make_shared<Literal_trie const>(tokens);
+
+    return [ops, trie, atom](std::string_view input) -> Parsed_t<T>
+    {
+        auto first = std::invoke(atom, input);
+        if (!first) return {};
+        input = first->second;
+
+        // Matches an operator and the atom after it, and sets index to the operator.
+        std::size_t index = 0;
+        auto const next = [&](std::string_view in) -> Parsed_t<T>
+        {
+            auto const op = std::invoke(skip_whitespace, in);
+            if (auto const found = trie->match(op->second)) {
+                index = found->first;
+                return std::invoke(atom, std::invoke(skip_whitespace, found->second)->second);
+            }
+            return {};
+        };
+
+        auto operand = next(input);
+        if (!operand) return first;
+
+        std::vector<T> operands;
+        std::vector<std::size_t> pending;
+        operands.push_back(std::move(first->first));
+
+        auto const reduce = [&]
+        {
+            auto rhs = std::move(operands.back());
+            operands.pop_back();
+            operands.back() = (*ops)[pending.back()].fold(std::move(operands.back()), std::move(rhs));
+            pending.pop_back();
+        };
+
+        do {
+            auto const& op = (*ops)[index];
+            while (!pending.empty()) {
+                auto const& top = (*ops)[pending.back()];
+                if (top.precedence > op.precedence ||
+                    (top.precedence == op.precedence && op.associativity == Associativity::left)) {
+                    reduce();
+                } else {
+                    break;
+                }
+            }
+            pending.push_back(index);
+            operands.push_back(std::move(operand->first));
+            input = operand->second;
+        } while ((operand = next(input)));
+
+        while (!pending.empty()) {
+            reduce();
+        }
+        return {{std::move(operands.back()), input}};
+    };
+}
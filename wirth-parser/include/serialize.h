@@ -0,0 +1,91 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "ast.h"
+#include "parsing.h"
+
+/*
+Binary AST format
+
+All integers are little-endian. The file starts with a fixed size header,
+followed by a node table, a child index table, a string pool and the source
+text:
+
+    offset  size  field
+    0       4     magic "WSNA"
+    4       2     format version
+    6       2     node record size (12)
+    8       4     node count
+    12      4     child index count
+    16      4     string pool size
+    20      4     root node index
+    24      8     source hash (0 if not cached from a source text)
+    32      8     source text size
+    40      8     number of source bytes consumed by the parse
+
+Each node record is { u8 kind, u8 factor type, u16 reserved, u32 a, u32 b }.
+Nodes are stored in post-order, so every child index is smaller than the index
+of its parent and a tree can be rebuilt in one forward pass over a
+memory-mapped file. Node lists refer to a range [a, a + b) in the child index
+table, and strings refer to a range [a, a + b) in the string pool. Identical
+strings are stored once. The source text is empty unless the tree was cached
+from it, and is compared with the input before the tree is used, so a hash
+collision cannot return the tree of another grammar.
+*/
+
+inline constexpr std::uint16_t ast_format_version = 2;
+
+struct Ast_source
+{
+    std::uint64_t hash = 0;
+    std::string text;
+    std::uint64_t consumed = 0;
+};
+
+std::string serialize(Ast const& x, Ast_source const& source = {});
+
+std::optional<Ast> deserialize(std::string_view bytes, Ast_source* source = nullptr);
+
+std::optional<Ast> load_ast(std::filesystem::path const& path, Ast_source* source = nullptr);
+
+// Writes to a temporary file of its own and renames it to path.
+bool save_ast(std::filesystem::path const& path, Ast const& x, Ast_source const& source = {});
+
+std::uint64_t content_hash(std::string_view input);
+
+// Parses a grammar with syntax(), or loads the result from a file in directory
+// named after the content hash of input if an earlier run has stored it there
+// for the same text.
+auto cached_syntax(std::string_view input, std::filesystem::path const& directory) -> Parsed_t<Ast>;
@@ -0,0 +1,66 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "ast.h"
+
+/*
+A push parser for grammars that arrive in chunks.
+
+Every production ends with a "." outside of a literal, so the stream only needs
+to track whether it is inside a literal to find where a production ends. Each
+complete production is parsed with production() and handed to the sink right
+away, and the buffer never holds more than the current chunk and the
+unfinished production before it.
+*/
+class Production_stream
+{
+public:
+
+    using Sink = std::function<void(Ast)>;
+
+    explicit Production_stream(Sink sink);
+
+    // Returns false if a production could not be parsed.
+    bool feed(std::string_view chunk);
+
+    // Returns false if the input ended inside a production.
+    bool finish();
+
+private:
+
+    Sink sink_;
+    std::string buffer_;
+    std::string::size_type scanned_ = 0;
+    bool in_literal_ = false;
+    bool failed_ = false;
+};
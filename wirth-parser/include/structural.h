@@ -0,0 +1,69 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+#include "parsing.h"
+#include "tokens.h"
+
+/*
+A structural index of a grammar, built like the first stage of simdjson. The
+text is classified 64 bytes at a time into bit masks of quotes, whitespace and
+identifier bytes, with SSE2 where available. The bytes inside literals are
+found with a prefix XOR over the quote mask, in which a doubled quote ends a
+literal and starts it again at once, so it needs no special case. The index is
+the offsets, in order, of the quotes that open and close each literal and of
+every byte outside literals that starts a token or stops lex(): the symbols
+= . | ( ) [ ] { }, the first byte of each identifier and anything else that is
+not whitespace. Input is limited to 4 GB, as offsets are 32 bits.
+*/
+auto structural_index(std::string_view input) -> std::vector<std::uint32_t>;
+
+// Like lex(), but jumps from token to token along a structural index of the
+// input instead of skipping whitespace and the insides of literals byte by byte.
+// Returns the same tokens and remainder as lex().
+auto indexed_lex(std::string_view input, std::span<std::uint32_t const> index) -> Parsed_t<std::vector<Token>>;
+
+// structural_index() and indexed_lex() followed by token_syntax(). Builds the
+// same tree as syntax(), and fails where it does.
+auto indexed_syntax(std::string_view input) -> Parsed_t<Ast>;
+
+// Like indexed_syntax(), but the tokens are split after the "." that ends a
+// production into up to threads chunks of about the same size, whose
+// productions are parsed on threads of their own. With 0 threads, one per core
+// is used. A grammar that does not parse to its end is parsed again in one
+// piece to find where it stops or fails. Nodes built on other threads are not
+// hash-consed by an Ast_interner in scope, and their steps do not count
+// against a bounded_parse().
+auto parallel_syntax(std::string_view input, std::size_t threads = 0) -> Parsed_t<Ast>;
@@ -0,0 +1,72 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+#include "parsing.h"
+
+/*
+A two-phase parser for grammars. lex() splits the text into tokens once, and
+the productions are then parsed over a std::span of tokens with the same
+combinators that syntax() uses over characters, so whitespace is never looked
+at twice and no alternative rescans the characters of a token.
+*/
+struct Token
+{
+    enum class Kind : std::uint8_t { identifier, literal, symbol };
+
+    Kind kind;
+
+    // For a literal, the text between the quotes with quotes still doubled.
+    std::string_view text;
+};
+
+using Tokens = std::span<Token const>;
+
+// Splits a grammar into identifiers, literals and the symbols = . | ( ) [ ] { },
+// skipping whitespace in between. Returns the text from the first character that
+// does not start a token.
+auto lex(std::string_view input) -> Parsed_t<std::vector<Token>>;
+
+// syntax = {production}, over tokens, with the same commit points as syntax().
+// A symbol token " stands for a quote mark that starts no literal, which fails
+// the parse where a factor is expected.
+auto token_syntax(Tokens input) -> Parsed_t<Ast, Tokens>;
+
+// lex() followed by token_syntax(). Builds the same tree as syntax(), and fails
+// where it does.
+auto lexed_syntax(std::string_view input) -> Parsed_t<Ast>;
+
+// token_syntax() over tokens lexed from input, with the remainder given as the
+// text from the first token that was not parsed. Fails if the lex did.
+auto lexed_syntax(std::string_view input, Parsed_t<std::vector<Token>> const& tokens) -> Parsed_t<Ast>;
@@ -0,0 +1,171 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <concepts>
+#include <string>
+#include <string_view>
+
+#include "parsing.h"
+
+// UTF-8 input
+
+// Checks that input is well-formed UTF-8: no stray continuation bytes,
+// overlong encodings, surrogates or code points above U+10FFFF. Runs of ASCII
+// are skipped 16 bytes at a time with SSE2 where available, but multibyte
+// sequences are checked one at a time by scalar code: the table lookups that
+// vectorized validators use need a byte shuffle, which SSE2 lacks.
+bool valid_utf8(std::string_view input);
+
+// Character classes for code points. ASCII is decided inline, and other code
+// points are looked up in tables covering the letters and decimal digits of
+// the common scripts (Latin, Greek, Cyrillic, Armenian, Hebrew, Arabic,
+// Devanagari, Thai, Georgian, Hangul, Ethiopic, Kana and CJK ideographs).
+bool is_unicode_letter(char32_t x);
+bool is_unicode_lower(char32_t x);
+bool is_unicode_upper(char32_t x);
+bool is_unicode_digit(char32_t x);
+
+constexpr bool
+is_letter(char32_t x)
+{
+    if (x < 0x80) {
+        return (x >= 'a' && x <= 'z') || (x >= 'A' && x <= 'Z');
+    } else {
+        return is_unicode_letter(x);
+    }
+}
+
+constexpr bool
+is_lower(char32_t x)
+{
+    return x < 0x80 ? x >= 'a' && x <= 'z' : is_unicode_lower(x);
+}
+
+constexpr bool
+is_upper(char32_t x)
+{
+    return x < 0x80 ? x >= 'A' && x <= 'Z' : is_unicode_upper(x);
+}
+
+constexpr bool
+is_digit(char32_t x)
+{
+    return x < 0x80 ? x >= '0' && x <= '9' : is_unicode_digit(x);
+}
+
+inline void
+append_utf8(std::string& st, char32_t x)
+{
+    if (x < 0x80) {
+        st += static_cast<char>(x);
+    } else if (x < 0x800) {
+        st += static_cast<char>(0xc0 | (x >> 6));
+        st += static_cast<char>(0x80 | (x & 0x3f));
+    } else if (x < 0x10000) {
+        st += static_cast<char>(0xe0 | (x >> 12));
+        st += static_cast<char>(0x80 | ((x >> 6) & 0x3f));
+        st += static_cast<char>(0x80 | (x & 0x3f));
+    } else {
+        st += static_cast<char>(0xf0 | (x >> 18));
+        st += static_cast<char>(0x80 | ((x >> 12) & 0x3f));
+        st += static_cast<char>(0x80 | ((x >> 6) & 0x3f));
+        st += static_cast<char>(0x80 | (x & 0x3f));
+    }
+}
+
+// Codepoint-level parsers
+
+// Like item, but consumes a whole UTF-8 sequence. Input is expected to have
+// passed valid_utf8, but malformed sequences fail rather than being split.
+inline constexpr auto
+code_point = [](std::string_view input) -> Parsed_t<char32_t>
+{
+    count_step();
+    if (input.empty()) return {};
+
+    auto const byte = [&](std::size_t i){ return static_cast<unsigned char>(input[i]); };
+    auto const lead = byte(0);
+    if (lead < 0x80) return {{lead, input.substr(1)}};
+
+    std::size_t const size = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 0;
+    if (size == 0 || input.size() < size) return {};
+    char32_t x = lead & (0x7f >> size);
+    for (std::size_t i = 1; i != size; ++i) {
+        if ((byte(i) & 0xc0) != 0x80) return {};
+        x = (x << 6) | (byte(i) & 0x3f);
+    }
+    return {{x, input.substr(size)}};
+};
+
+inline constexpr Parser auto
+u_digit = satisfy([](char32_t x){ return is_digit(x); }, code_point);
+
+inline constexpr Parser auto
+u_lower = satisfy([](char32_t x){ return is_lower(x); }, code_point);
+
+inline constexpr Parser auto
+u_upper = satisfy([](char32_t x){ return is_upper(x); }, code_point);
+
+inline constexpr Parser auto
+u_letter = satisfy([](char32_t x){ return is_letter(x); }, code_point);
+
+inline constexpr Parser auto
+u_alphanum = choice(u_letter, u_digit);
+
+constexpr Parser auto
+u_symbol(char32_t x)
+{
+    return satisfy([x](char32_t y){ return x == y; }, code_point);
+}
+
+// Collects code points into a UTF-8 encoded string, like many and some for char.
+
+template <Parser P>
+requires std::same_as<Parser_value_t<P>, char32_t>
+constexpr Parser auto
+many(P parser)
+{
+    return reduce_many(
+        std::string{},
+        parser,
+        [](std::string st, char32_t x){ append_utf8(st, x); return st; }
+    );
+}
+
+template <Parser P>
+requires std::same_as<Parser_value_t<P>, char32_t>
+constexpr Parser auto
+some(P parser)
+{
+    return sequence(
+        [](char32_t x, std::string st){ std::string ret; append_utf8(ret, x); st.insert(0, ret); return st; },
+        parser,
+        many(parser)
+    );
+}
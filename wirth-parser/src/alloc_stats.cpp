@@ -0,0 +1,240 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <vector>
+
+#include "alloc_stats.h"
+
+#ifdef WIRTH_PARSER_ALLOC_STATS
+
+namespace {
+
+struct Counters
+{
+    std::atomic<char const*> name{nullptr};
+    std::atomic<std::size_t> count{0};
+    std::atomic<std::size_t> bytes{0};
+    std::atomic<std::int64_t> live{0};
+    std::atomic<std::int64_t> peak{0};
+    std::atomic<std::size_t> copies{0};
+};
+
+// Slot 0 collects allocations made outside any phase.
+std::array<Counters, 64> phases;
+std::atomic<bool> details{false};
+thread_local std::uint32_t current = 0;
+
+std::uint32_t phase_index(char const* name)
+{
+    for (std::uint32_t i = 1; i != phases.size(); ++i) {
+        auto const* slot = phases[i].name.load();
+        if (slot == nullptr) {
+            if (phases[i].name.compare_exchange_strong(slot, name) || std::strcmp(slot, name) == 0) return i;
+        } else if (slot == name || std::strcmp(slot, name) == 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+struct Header
+{
+    std::size_t size;
+    std::uint32_t phase;
+    std::uint32_t offset;
+};
+static_assert(sizeof(Header) == 16);
+
+void* allocate(std::size_t size, std::size_t align)
+{
+    auto const offset = std::max(sizeof(Header), align);
+#ifdef _MSC_VER
+    auto* const base = static_cast<char*>(_aligned_malloc(size + offset, offset));
+#else
+    auto* const base = static_cast<char*>(
+        align > alignof(std::max_align_t)
+            ? std::aligned_alloc(align, (size + offset + align - 1) / align * align)
+            : std::malloc(size + offset)
+    );
+#endif
+    if (base == nullptr) return nullptr;
+
+    auto* const p = base + offset;
+    auto const phase = current;
+    Header const header{size, phase, static_cast<std::uint32_t>(offset)};
+    std::memcpy(p - sizeof(Header), &header, sizeof(Header));
+
+    auto& counters = phases[phase];
+    counters.count.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    auto const live = counters.live.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed)
+        + static_cast<std::int64_t>(size);
+    auto peak = counters.peak.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return p;
+}
+
+void deallocate(void* ptr)
+{
+    if (ptr == nullptr) return;
+    auto* const p = static_cast<char*>(ptr);
+    Header header;
+    std::memcpy(&header, p - sizeof(Header), sizeof(Header));
+    phases[header.phase].live.fetch_sub(static_cast<std::int64_t>(header.size), std::memory_order_relaxed);
+#ifdef _MSC_VER
+    _aligned_free(p - header.offset);
+#else
+    std::free(p - header.offset);
+#endif
+}
+
+void* allocate_or_throw(std::size_t size, std::size_t align)
+{
+    if (auto* const p = allocate(size, align)) return p;
+    throw std::bad_alloc{};
+}
+
+}
+
+void* operator new(std::size_t size) { return allocate_or_throw(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return allocate_or_throw(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t align) { return allocate_or_throw(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return allocate_or_throw(size, static_cast<std::size_t>(align)); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept { return allocate(size, alignof(std::max_align_t)); }
+
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete[](void* p) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { deallocate(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { deallocate(p); }
+
+Alloc_phase::Alloc_phase(char const* name, bool detail)
+    : previous_{current}, active_{!detail || details.load(std::memory_order_relaxed)}
+{
+    if (active_) current = phase_index(name);
+}
+
+Alloc_phase::~Alloc_phase()
+{
+    if (active_) current = previous_;
+}
+
+void alloc_count_copy()
+{
+    phases[current].copies.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool alloc_stats_enabled()
+{
+    return true;
+}
+
+void alloc_track_details(bool on)
+{
+    details = on;
+}
+
+std::vector<Alloc_stats> alloc_stats()
+{
+    std::vector<Alloc_stats> stats;
+    for (auto const& counters : phases) {
+        auto const* name = &counters == &phases[0] ? "other" : counters.name.load();
+        if (name == nullptr) break;
+        stats.push_back({name, counters.count, counters.bytes, counters.live, counters.peak, counters.copies});
+    }
+    return stats;
+}
+
+void alloc_stats_reset()
+{
+    // Blocks allocated before the reset are still credited back when they are
+    // freed, so live bytes are kept and the peak starts again from them.
+    for (auto& counters : phases) {
+        counters.count = 0;
+        counters.bytes = 0;
+        counters.peak = counters.live.load();
+        counters.copies = 0;
+    }
+}
+
+#else
+
+bool alloc_stats_enabled()
+{
+    return false;
+}
+
+void alloc_track_details(bool)
+{}
+
+std::vector<Alloc_stats> alloc_stats()
+{
+    return {};
+}
+
+void alloc_stats_reset()
+{}
+
+#endif
+
+void alloc_report(std::ostream& out, std::size_t input_size)
+{
+    auto const per_byte = [input_size](std::size_t n)
+    {
+        return input_size == 0 ? 0.0 : static_cast<double>(n) / static_cast<double>(input_size);
+    };
+
+    out << std::left << std::setw(16) << "phase" << std::right
+        << std::setw(12) << "allocs" << std::setw(14) << "bytes"
+        << std::setw(14) << "live" << std::setw(14) << "peak"
+        << std::setw(14) << "allocs/byte" << std::setw(14) << "bytes/byte"
+        << std::setw(12) << "copies" << '\n';
+    for (auto const& st : alloc_stats()) {
+        out << std::left << std::setw(16) << st.phase << std::right
+            << std::setw(12) << st.count << std::setw(14) << st.bytes
+            << std::setw(14) << st.live << std::setw(14) << st.peak
+            << std::fixed << std::setprecision(3)
+            << std::setw(14) << per_byte(st.count) << std::setw(14) << per_byte(st.bytes)
+            << std::setw(12) << st.copies << '\n';
+    }
+}
@@ -0,0 +1,605 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <bitset>
+#include <limits>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "analysis.h"
+#include "json.h"
+
+namespace {
+
+using Bytes = std::bitset<256>;
+
+constexpr auto unbounded = std::numeric_limits<std::size_t>::max();
+
+Bytes byte_range(unsigned char from, unsigned char to)
+{
+    Bytes bytes;
+    for (auto ch = from; ch <= to; ++ch) bytes.set(ch);
+    return bytes;
+}
+
+// The bytes each built-in identifier of emit_recognizer() can start with.
+std::optional<Bytes> builtin_bytes(std::string_view name)
+{
+    if (name == "lower") {
+        return byte_range('a', 'z');
+    } else if (name == "upper") {
+        return byte_range('A', 'Z');
+    } else if (name == "digit") {
+        return byte_range('0', '9');
+    } else if (name == "letter") {
+        return byte_range('a', 'z') | byte_range('A', 'Z');
+    } else if (name == "alphanum") {
+        return byte_range('a', 'z') | byte_range('A', 'Z') | byte_range('0', '9');
+    } else if (name == "character") {
+        return Bytes{}.set().reset('"');
+    } else if (name == "newline") {
+        return Bytes{}.set('\r').set('\n');
+    } else {
+        return {};
+    }
+}
+
+// Formats a set of bytes like a regular expression character class, with runs
+// as ranges, such as "0-9A-Z_a-z".
+std::string format_bytes(Bytes const& bytes)
+{
+    auto const byte = [](std::size_t x)
+    {
+        if (x < 0x20 || x >= 0x7f) {
+            constexpr std::string_view digits{"0123456789abcdef"};
+            return std::string{'\\', 'x', digits[x >> 4], digits[x & 0xf]};
+        }
+        auto const ch = static_cast<char>(x);
+        return ch == '-' || ch == '\\' || ch == ']' ? std::string{'\\', ch} : std::string(1, ch);
+    };
+    std::string ret;
+    for (std::size_t x = 0; x != bytes.size(); ++x) {
+        if (!bytes[x]) continue;
+        auto last = x;
+        while (last + 1 != bytes.size() && bytes[last + 1]) ++last;
+        if (last - x >= 2) {
+            ret += byte(x) + '-' + byte(last);
+        } else {
+            for (auto y = x; y <= last; ++y) ret += byte(y);
+        }
+        x = last;
+    }
+    return ret;
+}
+
+Expression const& expression_of(Ast const& x) { return *ast_cast<Expression>(x); }
+
+Term const& term_of(Ast const& x) { return *ast_cast<Term>(x); }
+
+Factor const& factor_of(Ast const& x) { return *ast_cast<Factor>(x); }
+
+std::string const& name_of(Ast const& x) { return ast_cast<Identifier>(x)->value; }
+
+std::vector<Term const*> terms_of(Expression const& e)
+{
+    std::vector<Term const*> ret{&term_of(e.term)};
+    for (auto const& t : e.terms) ret.push_back(&term_of(t));
+    return ret;
+}
+
+std::vector<Factor const*> factors_of(Term const& t)
+{
+    std::vector<Factor const*> ret{&factor_of(t.factor)};
+    for (auto const& f : t.factors) ret.push_back(&factor_of(f));
+    return ret;
+}
+
+// A reference from one production to another. It is a re-parse if the
+// production can be parsed again on the same input, by a later alternative.
+struct Edge
+{
+    std::size_t to;
+    bool reparse;
+};
+
+using Graph = std::vector<std::vector<Edge>>;
+
+// Returns the strongly connected component of each node, found by Tarjan's
+// algorithm with an explicit stack. Components are numbered in the order they
+// are completed, so edges only lead to components with the same or a lower
+// number.
+std::vector<std::size_t> components(Graph const& graph)
+{
+    constexpr auto none = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> index(graph.size(), none);
+    std::vector<std::size_t> low(graph.size());
+    std::vector<std::size_t> component(graph.size(), none);
+    std::vector<std::size_t> open;
+    std::vector<std::pair<std::size_t, std::size_t>> calls;
+    std::size_t next_index = 0;
+    std::size_t next_component = 0;
+
+    auto const enter = [&](std::size_t v)
+    {
+        index[v] = low[v] = next_index++;
+        open.push_back(v);
+        calls.emplace_back(v, 0);
+    };
+
+    for (std::size_t root = 0; root != graph.size(); ++root) {
+        if (index[root] != none) continue;
+        enter(root);
+        while (!calls.empty()) {
+            auto const v = calls.back().first;
+            if (auto const e = calls.back().second++; e != graph[v].size()) {
+                auto const w = graph[v][e].to;
+                if (index[w] == none) {
+                    enter(w);
+                } else if (component[w] == none) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+            if (low[v] == index[v]) {
+                std::size_t w;
+                do {
+                    w = open.back();
+                    open.pop_back();
+                    component[w] = next_component;
+                } while (w != v);
+                ++next_component;
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                auto const u = calls.back().first;
+                low[u] = std::min(low[u], low[v]);
+            }
+        }
+    }
+    return component;
+}
+
+struct Info
+{
+    bool nullable = false;
+    Bytes first;
+    Bytes follow;
+};
+
+class Analyzer
+{
+    std::vector<std::pair<std::string, Expression const*>> productions_;
+    std::map<std::string, std::size_t, std::less<>> index_;
+    std::vector<Info> info_;
+    std::set<std::string, std::less<>> const& lexical_;
+    // The productions each production can start with, directly.
+    std::vector<std::set<std::size_t>> left_;
+    Graph references_;
+    std::set<std::string, std::less<>> undefined_;
+    Grammar_analysis result_;
+
+    std::optional<std::size_t> production_index(std::string_view name) const
+    {
+        if (auto const found = index_.find(name); found != index_.end()) return found->second;
+        return {};
+    }
+
+    void report(Grammar_problem::Kind kind, std::size_t production, std::string message)
+    {
+        result_.problems.push_back({kind, productions_[production].first, std::move(message)});
+    }
+
+    bool nullable(Expression const& e) const
+    {
+        auto const terms = terms_of(e);
+        return std::ranges::any_of(terms, [this](Term const* t){ return nullable(*t); });
+    }
+
+    bool nullable(Term const& t) const
+    {
+        auto const factors = factors_of(t);
+        return std::ranges::all_of(factors, [this](Factor const* f){ return nullable(*f); });
+    }
+
+    bool nullable(Factor const& f) const
+    {
+        switch (f.type) {
+            case Factor::Type::id_v:
+                if (auto const i = production_index(name_of(f.value))) return info_[*i].nullable;
+                return false;
+            case Factor::Type::li_v:
+                return false;
+            case Factor::Type::gr_v:
+                return nullable(expression_of(f.value));
+            default:
+                return true;
+        }
+    }
+
+    Bytes first(Expression const& e) const
+    {
+        Bytes ret;
+        for (auto const* t : terms_of(e)) ret |= first(*t);
+        return ret;
+    }
+
+    Bytes first(Term const& t) const
+    {
+        Bytes ret;
+        for (auto const* f : factors_of(t)) {
+            ret |= first(*f);
+            if (!nullable(*f)) break;
+        }
+        return ret;
+    }
+
+    Bytes first(Factor const& f) const
+    {
+        switch (f.type) {
+            case Factor::Type::id_v: {
+                auto const& name = name_of(f.value);
+                if (auto const i = production_index(name)) return info_[*i].first;
+                return builtin_bytes(name).value_or(Bytes{});
+            }
+            case Factor::Type::li_v:
+                return Bytes{}.set(static_cast<unsigned char>(ast_cast<Literal>(f.value)->value.front()));
+            default:
+                return first(expression_of(f.value));
+        }
+    }
+
+    // Adds the bytes that can follow each production used in an expression,
+    // given the bytes that can follow the expression.
+    bool follow(Expression const& e, Bytes const& after)
+    {
+        bool changed = false;
+        for (auto const* t : terms_of(e)) {
+            auto const factors = factors_of(*t);
+            auto rest = after;
+            for (auto f = factors.rbegin(); f != factors.rend(); ++f) {
+                changed = follow(**f, rest) || changed;
+                rest = nullable(**f) ? first(**f) | rest : first(**f);
+            }
+        }
+        return changed;
+    }
+
+    bool follow(Factor const& f, Bytes const& after)
+    {
+        switch (f.type) {
+            case Factor::Type::id_v:
+                if (auto const i = production_index(name_of(f.value))) {
+                    auto const before = info_[*i].follow;
+                    info_[*i].follow |= after;
+                    return info_[*i].follow != before;
+                }
+                return false;
+            case Factor::Type::li_v:
+                return false;
+            case Factor::Type::re_v:
+                return follow(expression_of(f.value), first(expression_of(f.value)) | after);
+            default:
+                return follow(expression_of(f.value), after);
+        }
+    }
+
+    // Adds the productions an expression can start with, before it has
+    // consumed any input.
+    void leftmost(Expression const& e, std::set<std::size_t>& out) const
+    {
+        for (auto const* t : terms_of(e)) leftmost(*t, out);
+    }
+
+    void leftmost(Term const& t, std::set<std::size_t>& out) const
+    {
+        for (auto const* f : factors_of(t)) {
+            if (f->type == Factor::Type::id_v) {
+                if (auto const i = production_index(name_of(f->value))) out.insert(*i);
+            } else if (f->type != Factor::Type::li_v) {
+                leftmost(expression_of(f->value), out);
+            }
+            if (!nullable(*f)) break;
+        }
+    }
+
+    // The productions a term can start with, directly or through others.
+    std::set<std::size_t> left_closure(Term const& t) const
+    {
+        std::set<std::size_t> ret;
+        leftmost(t, ret);
+        std::vector<std::size_t> work(ret.begin(), ret.end());
+        while (!work.empty()) {
+            auto const p = work.back();
+            work.pop_back();
+            for (auto const q : left_[p]) {
+                if (ret.insert(q).second) work.push_back(q);
+            }
+        }
+        return ret;
+    }
+
+    void references(Expression const& e, std::size_t production)
+    {
+        for (auto const* t : terms_of(e)) {
+            for (auto const* f : factors_of(*t)) {
+                if (f->type == Factor::Type::id_v) {
+                    auto const& name = name_of(f->value);
+                    if (auto const i = production_index(name)) {
+                        references_[production].push_back({*i, false});
+                    } else if (!builtin_bytes(name) && undefined_.insert(name).second) {
+                        report(Grammar_problem::Kind::undefined_identifier, production, "uses undefined identifier " + name);
+                    }
+                } else if (f->type != Factor::Type::li_v) {
+                    references(expression_of(f->value), production);
+                }
+            }
+        }
+    }
+
+    // Reports the conflicts in an expression, given the bytes that can follow it.
+    void check(Expression const& e, Bytes const& after, std::size_t production)
+    {
+        auto const terms = terms_of(e);
+        auto const single_literal = [](Term const* t){ return t->factors.empty() && factor_of(t->factor).type == Factor::Type::li_v; };
+        if (terms.size() > 1 && !std::ranges::all_of(terms, single_literal)) {
+            for (std::size_t i = 0; i != terms.size(); ++i) {
+                for (auto j = i + 1; j != terms.size(); ++j) {
+                    auto const& a = *terms[i];
+                    auto const& b = *terms[j];
+                    auto const ends_a = nullable(a);
+                    auto const ends_b = nullable(b);
+                    auto overlap = first(a) & first(b);
+                    if (ends_a) overlap |= after & first(b);
+                    if (ends_b) overlap |= first(a) & after;
+                    auto const alternatives = "alternatives " + std::to_string(i + 1) + " and " + std::to_string(j + 1);
+                    if (ends_a && ends_b) {
+                        report(Grammar_problem::Kind::alternative_conflict, production, alternatives + " can both be empty");
+                    } else if (overlap.any()) {
+                        report(
+                            Grammar_problem::Kind::alternative_conflict, production,
+                            alternatives + " can both start with [" + format_bytes(overlap) + "]"
+                        );
+                    } else {
+                        continue;
+                    }
+
+                    // A production at the start of both is parsed again by the
+                    // second alternative when the first one fails.
+                    auto const left_a = left_closure(a);
+                    auto const left_b = left_closure(b);
+                    for (auto const q : left_a) {
+                        if (left_b.contains(q)) references_[production].push_back({q, true});
+                    }
+                }
+            }
+        }
+
+        for (auto const* t : terms) {
+            auto const factors = factors_of(*t);
+            auto rest = after;
+            for (auto f = factors.rbegin(); f != factors.rend(); ++f) {
+                check(**f, rest, production);
+                rest = nullable(**f) ? first(**f) | rest : first(**f);
+            }
+        }
+    }
+
+    void check(Factor const& f, Bytes const& after, std::size_t production)
+    {
+        if (f.type == Factor::Type::id_v || f.type == Factor::Type::li_v) return;
+        auto const& e = expression_of(f.value);
+        if (f.type == Factor::Type::op_v) {
+            if (auto const overlap = first(e) & after; overlap.any()) {
+                report(
+                    Grammar_problem::Kind::optional_conflict, production,
+                    "an optional part can start with [" + format_bytes(overlap) + "], which can also follow it"
+                );
+            }
+            check(e, after, production);
+        } else if (f.type == Factor::Type::re_v) {
+            if (nullable(e)) {
+                report(Grammar_problem::Kind::nullable_repetition, production, "a repetition can match the empty string");
+            } else if (auto const overlap = first(e) & after; overlap.any()) {
+                report(
+                    Grammar_problem::Kind::repetition_conflict, production,
+                    "a repetition can start with [" + format_bytes(overlap) + "], which can also follow it"
+                );
+            }
+            check(e, first(e) | after, production);
+        } else {
+            check(e, after, production);
+        }
+    }
+
+    void find_left_recursion()
+    {
+        Graph graph(productions_.size());
+        for (std::size_t i = 0; i != productions_.size(); ++i) {
+            for (auto const q : left_[i]) graph[i].push_back({q, false});
+        }
+        auto const component = components(graph);
+        std::map<std::size_t, std::vector<std::size_t>> members;
+        for (std::size_t i = 0; i != productions_.size(); ++i) members[component[i]].push_back(i);
+        for (std::size_t i = 0; i != productions_.size(); ++i) {
+            auto const& cycle = members[component[i]];
+            auto const self = std::ranges::any_of(graph[i], [i](Edge const& e){ return e.to == i; });
+            if (cycle.size() == 1 && !self) continue;
+            result_.productions[i].left_recursive = true;
+            std::string names;
+            for (auto const q : cycle) names += (names.empty() ? "" : ", ") + productions_[q].first;
+            report(Grammar_problem::Kind::left_recursion, i, "is left recursive through " + names);
+        }
+    }
+
+    // The backtracking depth of a production is the largest number of
+    // re-parse edges on a path from it. A re-parse edge within a cycle makes
+    // it unbounded.
+    void find_backtracking_depth()
+    {
+        auto const component = components(references_);
+        auto const count = productions_.empty() ? 0 : *std::ranges::max_element(component) + 1;
+        std::vector<std::vector<std::size_t>> members(count);
+        for (std::size_t i = 0; i != productions_.size(); ++i) members[component[i]].push_back(i);
+
+        std::vector<std::size_t> depth(count, 0);
+        for (std::size_t c = 0; c != count; ++c) {
+            bool reparse_cycle = false;
+            for (auto const i : members[c]) {
+                for (auto const& [to, reparse] : references_[i]) {
+                    if (component[to] == c) {
+                        reparse_cycle = reparse_cycle || reparse;
+                    } else if (depth[component[to]] == unbounded) {
+                        depth[c] = unbounded;
+                    } else if (depth[c] != unbounded) {
+                        depth[c] = std::max(depth[c], depth[component[to]] + (reparse ? 1 : 0));
+                    }
+                }
+            }
+            if (reparse_cycle) {
+                depth[c] = unbounded;
+                std::string names;
+                for (auto const q : members[c]) names += (names.empty() ? "" : ", ") + productions_[q].first;
+                report(
+                    Grammar_problem::Kind::unbounded_backtracking, members[c].front(),
+                    "parses the same input again in nested choices through " + names
+                );
+            }
+        }
+
+        std::size_t max_depth = 0;
+        for (std::size_t i = 0; i != productions_.size(); ++i) {
+            auto const d = depth[component[i]];
+            if (d != unbounded) result_.productions[i].backtracking_depth = d;
+            max_depth = std::max(max_depth, d);
+        }
+        if (max_depth != unbounded) result_.max_backtracking_depth = max_depth;
+    }
+
+public:
+
+    Analyzer(Syntax const& syntax, std::set<std::string, std::less<>> const& lexical)
+        : lexical_{lexical}
+    {
+        for (auto const& p : syntax.productions) {
+            auto const& production = *ast_cast<Production>(p);
+            auto const& name = name_of(production.identifier);
+            if (index_.try_emplace(name, productions_.size()).second) {
+                productions_.emplace_back(name, &expression_of(production.expression));
+            }
+        }
+        info_.resize(productions_.size());
+        left_.resize(productions_.size());
+        references_.resize(productions_.size());
+    }
+
+    Grammar_analysis run() &&
+    {
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t i = 0; i != productions_.size(); ++i) {
+                auto const& e = *productions_[i].second;
+                auto const n = nullable(e);
+                auto const f = first(e);
+                changed = changed || n != info_[i].nullable || f != info_[i].first;
+                info_[i].nullable = n;
+                info_[i].first = f;
+            }
+        }
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t i = 0; i != productions_.size(); ++i) {
+                auto const after = info_[i].follow;
+                changed = follow(*productions_[i].second, after) || changed;
+            }
+        }
+
+        for (std::size_t i = 0; i != productions_.size(); ++i) leftmost(*productions_[i].second, left_[i]);
+        for (std::size_t i = 0; i != productions_.size(); ++i) {
+            result_.productions.push_back({
+                productions_[i].first, info_[i].nullable, format_bytes(info_[i].first), format_bytes(info_[i].follow), false, {}
+            });
+            references(*productions_[i].second, i);
+            auto const lexical = lexical_.contains(productions_[i].first);
+            check(*productions_[i].second, lexical ? Bytes{} : info_[i].follow, i);
+        }
+        find_left_recursion();
+        find_backtracking_depth();
+        std::ranges::stable_sort(result_.problems, {}, [](Grammar_problem const& p){ return !p.is_error(); });
+        return std::move(result_);
+    }
+};
+
+constexpr std::string_view kind_names[] = {
+    "undefined_identifier", "left_recursion", "nullable_repetition", "unbounded_backtracking",
+    "alternative_conflict", "optional_conflict", "repetition_conflict",
+};
+
+} // namespace
+
+bool Grammar_analysis::linear() const
+{
+    return std::ranges::none_of(problems, &Grammar_problem::is_error) && max_backtracking_depth.has_value();
+}
+
+Grammar_analysis analyze(Ast const& syntax, std::set<std::string, std::less<>> const& lexical)
+{
+    return Analyzer{*ast_cast<Syntax>(syntax), lexical}.run();
+}
+
+void write_json(Grammar_analysis const& analysis, std::ostream& out)
+{
+    out << "{\n  \"linear\": " << (analysis.linear() ? "true" : "false") << ",\n  \"max_backtracking_depth\": ";
+    if (analysis.max_backtracking_depth) out << *analysis.max_backtracking_depth; else out << "null";
+    out << ",\n  \"problems\": [";
+    for (auto const& p : analysis.problems) {
+        out << (&p == &analysis.problems.front() ? "\n" : ",\n")
+            << "    {\"kind\": \"" << kind_names[static_cast<std::size_t>(p.kind)]
+            << "\", \"severity\": \"" << (p.is_error() ? "error" : "warning")
+            << "\", \"production\": " << json_string(p.production)
+            << ", \"message\": " << json_string(p.message) << '}';
+    }
+    out << (analysis.problems.empty() ? "],\n" : "\n  ],\n") << "  \"productions\": [";
+    for (auto const& p : analysis.productions) {
+        out << (&p == &analysis.productions.front() ? "\n" : ",\n")
+            << "    {\"name\": " << json_string(p.name)
+            << ", \"nullable\": " << (p.nullable ? "true" : "false")
+            << ", \"first\": " << json_string(p.first)
+            << ", \"follow\": " << json_string(p.follow)
+            << ", \"left_recursive\": " << (p.left_recursive ? "true" : "false")
+            << ", \"backtracking_depth\": ";
+        if (p.backtracking_depth) out << *p.backtracking_depth; else out << "null";
+        out << '}';
+    }
+    out << (analysis.productions.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
@@ -25,9 +25,14 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org>
 */
 
+#include <algorithm>
 #include <optional>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "ast.h"
 
@@ -36,81 +41,386 @@ std::string indent(std::string::size_type in)
     return std::string(in, ' ');
 }
 
+Ast::~Ast()
+{
+    // While a tree is being torn down, nodes that lose their last owner are
+    // handed over to the outermost destructor instead of being destroyed in
+    // place, so the call stack stays flat however deeply the tree is nested.
+    thread_local std::vector<std::shared_ptr<Concept const>>* orphans = nullptr;
+
+    if (!self_ || self_.use_count() != 1) return;
+    if (orphans) {
+        orphans->push_back(std::move(self_));
+        return;
+    }
+
+    std::vector<std::shared_ptr<Concept const>> pending;
+    orphans = &pending;
+    self_.reset();
+    while (!pending.empty()) {
+        auto node = std::move(pending.back());
+        pending.pop_back();
+        node.reset();
+    }
+    orphans = nullptr;
+}
+
+std::weak_ptr<Ast::Concept const>& Ast::interned(std::string_view key, std::size_t size)
+{
+    auto& interner = *interner_;
+    ++interner.nodes_;
+    interner.bytes_ += size;
+
+    // Entries of nodes that have died are dropped whenever the table has
+    // doubled, so nodes built and thrown away by backtracking do not pile up.
+    if (interner.table_.size() >= interner.sweep_at_) {
+        std::erase_if(interner.table_, [](auto const& entry){ return entry.second.expired(); });
+        interner.sweep_at_ = std::max<std::size_t>(1024, 2 * interner.table_.size());
+    }
+
+    auto found = interner.table_.find(key);
+    if (found == interner.table_.end()) {
+        found = interner.table_.emplace(key, std::weak_ptr<Concept const>{}).first;
+    } else if (!found->second.expired()) {
+        ++interner.shared_;
+        interner.shared_bytes_ += size;
+    }
+    return found->second;
+}
+
+Ast_interner::Ast_interner() : outer_{Ast::interner_}
+{
+    Ast::interner_ = this;
+}
+
+Ast_interner::~Ast_interner()
+{
+    Ast::interner_ = outer_;
+}
+
+std::size_t Ast_interner::nodes() const
+{
+    return nodes_;
+}
+
+std::size_t Ast_interner::shared() const
+{
+    return shared_;
+}
+
+std::size_t Ast_interner::bytes() const
+{
+    return bytes_;
+}
+
+std::size_t Ast_interner::shared_bytes() const
+{
+    return shared_bytes_;
+}
+
+void children(Ast const& x, std::vector<Ast const*>& out)
+{
+    x.self_->children_(out);
+}
+
 std::string fmt(Ast const& x, std::string::size_type in)
 {
-    return x.self_->fmt_(in);
+    struct Entered
+    {
+        std::string::size_type in;
+        std::size_t children;
+    };
+
+    std::vector<std::string::size_type> indents{in};
+    std::vector<Entered> entered;
+    std::vector<std::string> results;
+    std::vector<Ast const*> kids;
+
+    traverse(
+        x,
+        [&](Ast const& node)
+        {
+            auto const node_in = indents.back();
+            indents.pop_back();
+            kids.clear();
+            children(node, kids);
+            entered.push_back({node_in, kids.size()});
+            for (auto i = kids.size(); i-- != 0;) {
+                indents.push_back(node.self_->indent_(node_in, i));
+            }
+        },
+        [&](Ast const& node)
+        {
+            auto const [node_in, count] = entered.back();
+            entered.pop_back();
+            auto const first = results.end() - static_cast<std::ptrdiff_t>(count);
+            auto st = node.self_->fmt_(node_in, {first, results.end()});
+            results.erase(first, results.end());
+            results.push_back(std::move(st));
+        }
+    );
+    return std::move(results.back());
 }
 
-std::string fmt(Syntax const& x, std::string::size_type in)
+struct Lazy::State
+{
+    std::string_view source;
+    Parse parse;
+    std::once_flag once;
+    std::optional<Ast> value;
+};
+
+Lazy::Lazy(std::string_view source, Parse parse)
+    : state_{std::make_shared<State>(source, parse)}
+{}
+
+std::string_view Lazy::source() const
+{
+    return state_->source;
+}
+
+Ast const& Lazy::get() const
+{
+    std::call_once(state_->once, [this]{ state_->value.emplace(state_->parse(state_->source)); });
+    return *state_->value;
+}
+
+void children(Lazy const& x, std::vector<Ast const*>& out)
+{
+    out.push_back(&x.get());
+}
+
+std::string::size_type child_indent(Lazy const&, std::string::size_type in, std::size_t)
+{
+    return in;
+}
+
+std::string fmt(Lazy const&, std::string::size_type, std::span<std::string const> children)
+{
+    return children[0];
+}
+
+std::string fmt(Lazy const& x, std::string::size_type in)
+{
+    return fmt(x.get(), in);
+}
+
+void children(Syntax const& x, std::vector<Ast const*>& out)
+{
+    for (auto const& production : x.productions) out.push_back(&production);
+}
+
+std::string::size_type child_indent(Syntax const&, std::string::size_type in, std::size_t)
+{
+    return in;
+}
+
+std::string fmt(Syntax const&, std::string::size_type, std::span<std::string const> children)
 {
     std::string res;
-    for (auto const& production : x.productions) {
-        res += fmt(production, in) + "\n\n";
+    for (auto const& production : children) {
+        res += production + "\n\n";
     }
     return res;
 }
 
-std::string fmt(Production const& x, std::string::size_type)
+std::string fmt(Syntax const& x, std::string::size_type in)
+{
+    return fmt(Ast{x}, in);
+}
+
+bool hash_cons_key(Syntax const&, std::string&)
+{
+    return true;
+}
+
+void children(Production const& x, std::vector<Ast const*>& out)
+{
+    out.push_back(&x.identifier);
+    out.push_back(&x.expression);
+}
+
+std::string::size_type child_indent(Production const&, std::string::size_type, std::size_t child)
+{
+    return child == 0 ? 0 : 8;
+}
+
+std::string fmt(Production const&, std::string::size_type, std::span<std::string const> children)
 {
     return
-        "auto " + fmt(x.identifier, 0) + "(std::string_view input)\n{\n" +
+        "auto " + children[0] + "(std::string_view input)\n{\n" +
         indent(4) + "return\n" +
-        indent(8) + fmt(x.expression, 8) +
+        indent(8) + children[1] +
         "(input);\n}";
 }
 
-std::string fmt(Expression const& x, std::string::size_type in)
+std::string fmt(Production const& x, std::string::size_type in)
+{
+    return fmt(Ast{x}, in);
+}
+
+bool hash_cons_key(Production const&, std::string&)
+{
+    return true;
+}
+
+void children(Expression const& x, std::vector<Ast const*>& out)
+{
+    out.push_back(&x.term);
+    for (auto const& t : x.terms) out.push_back(&t);
+}
+
+std::string::size_type child_indent(Expression const& x, std::string::size_type in, std::size_t)
+{
+    return x.terms.empty() ? in : in + 4;
+}
+
+Literal const* single_literal(Ast const& term)
 {
-    if (x.terms.empty() == 1) {
-        return fmt(x.term, in);
+    if (auto const* t = ast_cast<Term>(term); t && t->factors.empty()) {
+        if (auto const* f = ast_cast<Factor>(t->factor); f && f->type == Factor::Type::li_v) {
+            return ast_cast<Literal>(f->value);
+        }
+    }
+    return nullptr;
+}
+
+namespace {
+
+std::string quoted(std::string const& value)
+{
+    std::string ret = "\"";
+    for (auto const ch : value) {
+        if (ch == '"' || ch == '\\') ret += '\\';
+        ret += ch;
+    }
+    return ret + '"';
+}
+
+} // namespace
+
+std::string fmt(Expression const& x, std::string::size_type in, std::span<std::string const> children)
+{
+    auto const all_literals = single_literal(x.term) && std::all_of(
+        x.terms.begin(), x.terms.end(), [](Ast const& t){ return single_literal(t) != nullptr; }
+    );
+
+    if (x.terms.empty()) {
+        return children[0];
+    } else if (all_literals) {
+        std::string ret = "literals({" + quoted(single_literal(x.term)->value);
+        for (auto const& t : x.terms) {
+            ret += ", " + quoted(single_literal(t)->value);
+        }
+        return ret + "})";
     } else {
         std::string ret = "choice(\n";
-        ret += indent(in + 4) + fmt(x.term, in + 4);
-        for (auto t : x.terms) {
-            ret += ",\n" + indent(in + 4) + fmt(t, in + 4);
+        ret += indent(in + 4) + children[0];
+        for (auto const& t : children.subspan(1)) {
+            ret += ",\n" + indent(in + 4) + t;
         }
         ret += '\n' + indent(in) + ")";
         return ret;
     }
 }
 
-std::string fmt(Term const& x, std::string::size_type in)
+std::string fmt(Expression const& x, std::string::size_type in)
+{
+    return fmt(Ast{x}, in);
+}
+
+bool hash_cons_key(Expression const&, std::string&)
+{
+    return true;
+}
+
+void children(Term const& x, std::vector<Ast const*>& out)
+{
+    out.push_back(&x.factor);
+    for (auto const& f : x.factors) out.push_back(&f);
+}
+
+std::string::size_type child_indent(Term const&, std::string::size_type in, std::size_t child)
+{
+    return child == 0 ? in : in + 4;
+}
+
+std::string fmt(Term const& x, std::string::size_type in, std::span<std::string const> children)
 {
     if (x.factors.empty()) {
-        return fmt(x.factor, in);
+        return children[0];
     } else {
         std::string ret = "sequence(\n";
         ret += indent(in + 4) + "[](auto";
-        for (auto f : x.factors) {
+        for (std::size_t i = 0; i != x.factors.size(); ++i) {
             ret += ", auto";
         }
         ret += "){ return /* TODO */; },\n";
-        ret += indent(in + 4) + fmt(x.factor, in);
-        for (auto f : x.factors) {
-            ret += ",\n" + indent(in + 4) + fmt(f, in + 4);
+        ret += indent(in + 4) + children[0];
+        for (auto const& f : children.subspan(1)) {
+            ret += ",\n" + indent(in + 4) + f;
         }
         ret += '\n' + indent(in) + ")";
         return ret;
     }
 }
 
-std::string fmt(Factor const& x, std::string::size_type in)
+std::string fmt(Term const& x, std::string::size_type in)
+{
+    return fmt(Ast{x}, in);
+}
+
+bool hash_cons_key(Term const&, std::string&)
+{
+    return true;
+}
+
+void children(Factor const& x, std::vector<Ast const*>& out)
+{
+    out.push_back(&x.value);
+}
+
+std::string::size_type child_indent(Factor const& x, std::string::size_type in, std::size_t)
+{
+    switch (x.type) {
+        case Factor::Type::gr_v:
+            return in + 8;
+        case Factor::Type::op_v:
+        case Factor::Type::re_v:
+            return in + 4;
+        default:
+            return in;
+    }
+}
+
+std::string fmt(Factor const& x, std::string::size_type in, std::span<std::string const> children)
 {
     switch (x.type) {
         case Factor::Type::id_v:
-            return fmt(x.value, in);
+            return children[0];
         case Factor::Type::li_v:
-            return fmt(x.value, in);
+            return children[0];
         case Factor::Type::gr_v:
-            return "(\n" + indent(in + 8) + fmt(x.value, in + 8) + '\n' + indent(in + 4) + ')';
+            return "(\n" + indent(in + 8) + children[0] + '\n' + indent(in + 4) + ')';
         case Factor::Type::op_v:
-            return "maybe(\n" + indent(in + 4) + fmt(x.value, in + 4) + '\n' + indent(in) + ')';
+            return "maybe(\n" + indent(in + 4) + children[0] + '\n' + indent(in) + ')';
         case Factor::Type::re_v:
-            return "repeat(\n" + indent(in + 4) + fmt(x.value, in + 4) + '\n' + indent(in) + ')';
+            return "repeat(\n" + indent(in + 4) + children[0] + '\n' + indent(in) + ')';
     }
     return "";
 }
 
+std::string fmt(Factor const& x, std::string::size_type in)
+{
+    return fmt(Ast{x}, in);
+}
+
+bool hash_cons_key(Factor const& x, std::string& key)
+{
+    key += static_cast<char>(x.type);
+    return true;
+}
+
 std::string fmt(Literal const& x, std::string::size_type)
 {
     if (x.value.length() == 1) {
@@ -120,16 +430,34 @@ std::string fmt(Literal const& x, std::string::size_type)
     }
 }
 
+bool hash_cons_key(Literal const& x, std::string& key)
+{
+    key += x.value;
+    return true;
+}
+
 std::string fmt(Identifier const& x, std::string::size_type)
 {
     return x.value;
 }
 
+bool hash_cons_key(Identifier const& x, std::string& key)
+{
+    key += x.value;
+    return true;
+}
+
 std::string fmt(Character const& x, std::string::size_type)
 {
     return std::string{x.value};
 }
 
+bool hash_cons_key(Character const& x, std::string& key)
+{
+    key += x.value;
+    return true;
+}
+
 std::string fmt(std::vector<Ast> const& xs, std::string::size_type in)
 {
     std::string ret;
@@ -0,0 +1,258 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "codegen.h"
+
+namespace {
+
+constexpr std::string_view builtin_definitions =
+    "namespace builtin {\n"
+    "\n"
+    "inline constexpr Parser auto letter = ::skip_sequence(::letter);\n"
+    "inline constexpr Parser auto lower = ::skip_sequence(::lower);\n"
+    "inline constexpr Parser auto upper = ::skip_sequence(::upper);\n"
+    "inline constexpr Parser auto digit = ::skip_sequence(::digit);\n"
+    "inline constexpr Parser auto alphanum = ::skip_sequence(::alphanum);\n"
+    "inline constexpr Parser auto character = ::skip_sequence(::satisfy([](char x){ return x != '\"'; }));\n"
+    "inline constexpr Parser auto newline = ::choice(::skip_str(\"\\r\\n\"), ::skip_str(\"\\n\"));\n"
+    "\n"
+    "template <Parser P>\n"
+    "constexpr Parser auto\n"
+    "lexeme(P parser)\n"
+    "{\n"
+    "    return ::skip_sequence(::skip_whitespace, parser);\n"
+    "}\n"
+    "\n"
+    "} // namespace builtin\n";
+
+// C++ keywords, and the names the generated code uses itself.
+constexpr std::string_view reserved[] = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "builtin", "case",
+    "catch", "char", "char16_t", "char32_t", "char8_t", "class", "co_await", "co_return", "co_yield", "compl",
+    "concept", "const", "const_cast", "consteval", "constexpr", "constinit", "continue", "decltype", "default",
+    "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float",
+    "for", "friend", "goto", "if", "inline", "input", "int", "long", "mutable", "namespace", "new", "noexcept",
+    "not", "not_eq", "nullptr", "operator", "or", "or_eq", "parser", "private", "protected", "public",
+    "register", "reinterpret_cast", "requires", "return", "short", "signed", "sizeof", "static",
+    "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true",
+    "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq",
+};
+
+template <typename Range>
+bool contains(Range const& names, std::string_view name)
+{
+    return std::find(std::begin(names), std::end(names), name) != std::end(names);
+}
+
+// Escapes a character for a C++ literal delimited by quote.
+std::string escaped(char ch, char quote)
+{
+    switch (ch) {
+        case '\n': return "\\n";
+        case '\r': return "\\r";
+        case '\t': return "\\t";
+        case '\\': return "\\\\";
+        default: break;
+    }
+    if (ch == quote) {
+        return std::string{'\\', ch};
+    } else if (static_cast<unsigned char>(ch) < 0x20 || ch == 0x7f) {
+        auto const x = static_cast<unsigned char>(ch);
+        return {'\\', static_cast<char>('0' + (x >> 6)), static_cast<char>('0' + ((x >> 3) & 7)), static_cast<char>('0' + (x & 7))};
+    } else {
+        return std::string(1, ch);
+    }
+}
+
+std::string string_literal(std::string_view value)
+{
+    std::string ret = "\"";
+    for (auto const ch : value) ret += escaped(ch, '"');
+    return ret + '"';
+}
+
+// Formats a call with one argument per line, in the layout of fmt().
+std::string call(std::string_view func, std::vector<std::string> const& args, std::string::size_type in)
+{
+    std::string ret{func};
+    ret += "(\n";
+    for (std::size_t i = 0; i != args.size(); ++i) {
+        ret += indent(in + 4) + args[i] + (i + 1 == args.size() ? "\n" : ",\n");
+    }
+    return ret + indent(in) + ")";
+}
+
+class Recognizer_writer
+{
+    Recognizer_options const& options_;
+    std::set<std::string, std::less<>> defined_;
+    bool lexical_ = false;
+    bool undefined_ = false;
+
+    bool is_lexical(std::string_view name) const
+    {
+        return options_.lexical.contains(name);
+    }
+
+    std::string lexeme(std::string st) const
+    {
+        return lexical_ ? st : "builtin::lexeme(" + st + ")";
+    }
+
+    std::string expression(Expression const& e, std::string::size_type in)
+    {
+        if (e.terms.empty()) {
+            return term(*ast_cast<Term>(e.term), in);
+        }
+
+        std::vector<Ast const*> terms{&e.term};
+        for (auto const& t : e.terms) terms.push_back(&t);
+
+        if (std::all_of(terms.begin(), terms.end(), [](Ast const* t){ return single_literal(*t); })) {
+            std::string set;
+            for (auto const* t : terms) {
+                set += (set.empty() ? "" : ", ") + string_literal(single_literal(*t)->value);
+            }
+            return lexeme("::skip_sequence(::one_of({" + set + "}))");
+        }
+
+        std::vector<std::string> args;
+        for (auto const* t : terms) args.push_back(term(*ast_cast<Term>(*t), in + 4));
+        return call("::choice", args, in);
+    }
+
+    std::string term(Term const& t, std::string::size_type in)
+    {
+        if (t.factors.empty()) {
+            return factor(*ast_cast<Factor>(t.factor), in);
+        }
+
+        std::vector<std::string> args{factor(*ast_cast<Factor>(t.factor), in + 4)};
+        for (auto const& f : t.factors) args.push_back(factor(*ast_cast<Factor>(f), in + 4));
+        return call("::skip_sequence", args, in);
+    }
+
+    std::string factor(Factor const& f, std::string::size_type in)
+    {
+        switch (f.type) {
+            case Factor::Type::id_v: {
+                auto const& name = ast_cast<Identifier>(f.value)->value;
+                if (is_builtin(name)) {
+                    return lexeme("builtin::" + name);
+                } else if (!defined_.contains(name)) {
+                    undefined_ = true;
+                    return name;
+                } else if (is_lexical(name)) {
+                    return lexeme(function_name(name));
+                } else {
+                    return function_name(name);
+                }
+            }
+            case Factor::Type::li_v: {
+                auto const& value = ast_cast<Literal>(f.value)->value;
+                if (value.size() == 1) {
+                    return lexeme("::skip_sequence(::symbol('" + escaped(value[0], '\'') + "'))");
+                } else {
+                    return lexeme("::skip_str(" + string_literal(value) + ")");
+                }
+            }
+            case Factor::Type::gr_v:
+                return expression(*ast_cast<Expression>(f.value), in);
+            case Factor::Type::op_v:
+                return call("::skip_maybe", {expression(*ast_cast<Expression>(f.value), in + 4)}, in);
+            case Factor::Type::re_v:
+                return call("::skip_many", {expression(*ast_cast<Expression>(f.value), in + 4)}, in);
+        }
+        return {};
+    }
+
+public:
+
+    explicit Recognizer_writer(Recognizer_options const& options)
+        : options_{options}
+    {}
+
+    static std::string function_name(std::string const& name)
+    {
+        return contains(reserved, name) ? name + '_' : name;
+    }
+
+    bool write(Syntax const& syntax, std::ostream& out)
+    {
+        std::vector<Production const*> productions;
+        for (auto const& p : syntax.productions) {
+            auto const* production = ast_cast<Production>(p);
+            productions.push_back(production);
+            defined_.insert(ast_cast<Identifier>(production->identifier)->value);
+        }
+
+        std::string body;
+        for (auto const* production : productions) {
+            auto const& name = ast_cast<Identifier>(production->identifier)->value;
+            if (is_builtin(name)) continue;
+            lexical_ = is_lexical(name);
+            body +=
+                "\ninline auto " + function_name(name) + "(std::string_view input) -> Parsed_t<Unit>\n{\n" +
+                indent(4) + "static auto const parser =\n" +
+                indent(8) + expression(*ast_cast<Expression>(production->expression), 8) + ";\n" +
+                indent(4) + "return parser(input);\n}\n";
+        }
+        if (undefined_) return false;
+
+        out << "// Recognizers generated by wirth-parser from a WSN grammar.\n\n"
+               "#pragma once\n\n"
+               "#include <string_view>\n\n"
+               "#include \"parsing.h\"\n\n"
+               "namespace " << options_.name_space << " {\n\n";
+        for (auto const* production : productions) {
+            auto const& name = ast_cast<Identifier>(production->identifier)->value;
+            if (is_builtin(name)) continue;
+            out << "inline auto " << function_name(name) << "(std::string_view input) -> Parsed_t<Unit>;\n";
+        }
+        out << '\n' << builtin_definitions << body << "\n} // namespace " << options_.name_space << '\n';
+        return static_cast<bool>(out);
+    }
+};
+
+} // namespace
+
+bool emit_recognizer(Ast const& syntax, Recognizer_options const& options, std::ostream& out)
+{
+    if (auto const* grammar = ast_cast<Syntax>(syntax)) {
+        return Recognizer_writer{options}.write(*grammar, out);
+    } else {
+        return false;
+    }
+}
@@ -0,0 +1,1002 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "earley.h"
+#include "parser.h"
+#include "utf8.h"
+
+namespace {
+
+using Id = std::uint32_t;
+
+constexpr auto none = std::numeric_limits<Id>::max();
+
+// In the order of builtin_names.
+enum class Builtin : std::uint8_t { letter, lower, upper, digit, alphanum, character, newline };
+
+std::optional<Builtin> builtin(std::string_view name)
+{
+    auto const found = std::ranges::find(builtin_names, name);
+    if (found == std::end(builtin_names)) return {};
+    return static_cast<Builtin>(found - std::begin(builtin_names));
+}
+
+// An Earley item: a rule with a dot in it, numbered as in Grammar::next, and
+// the position where the rule started.
+struct Item
+{
+    Id dotted;
+    Id origin;
+
+    friend bool operator==(Item, Item) = default;
+};
+
+std::uint64_t key(Item x)
+{
+    return std::uint64_t{x.dotted} << 32 | x.origin;
+}
+
+} // namespace
+
+struct Earley_parser::Grammar
+{
+    struct Symbol
+    {
+        enum class Kind : std::uint8_t { nonterminal, literal, builtin, token };
+
+        Kind kind;
+        // Whether whitespace is skipped before a terminal.
+        bool skip = false;
+        Builtin builtin = Builtin::letter;
+        std::string literal;
+        // The nonterminal of a nonterminal, or the lexical production of a token.
+        Id nonterminal = none;
+
+        friend auto operator<=>(Symbol const&, Symbol const&) = default;
+    };
+
+    struct Nonterminal
+    {
+        // Empty for groups, optional and repeated parts, whose matches become
+        // part of the production they are in.
+        std::string name;
+        bool lexical = false;
+        bool repetition = false;
+        Id symbol = none;
+        std::vector<Id> rules;
+        // A nonterminal with the single rule start = this, for parsing this
+        // production on its own.
+        Id start = none;
+    };
+
+    struct Rule
+    {
+        Id lhs;
+        std::vector<Id> rhs;
+        Id alternative;
+        // The number of the rule with the dot at its start.
+        Id dotted;
+    };
+
+    std::vector<Symbol> symbols;
+    std::vector<Nonterminal> nonterminals;
+    std::vector<Rule> rules;
+
+    // For each rule with a dot, the rule, and the symbol after the dot or none.
+    std::vector<Id> rule_of;
+    std::vector<Id> next;
+
+    Id start = none;
+    bool lexical_start = false;
+
+    Id lhs(Id dotted) const { return rules[rule_of[dotted]].lhs; }
+
+    bool is_nonterminal(Id symbol) const { return symbols[symbol].kind == Symbol::Kind::nonterminal; }
+};
+
+namespace {
+
+using Grammar = Earley_parser::Grammar;
+using Kind = Grammar::Symbol::Kind;
+
+class Compiler
+{
+    Grammar& g_;
+    std::map<std::string, Id, std::less<>> productions_;
+    std::map<Grammar::Symbol, Id> terminals_;
+
+    Id nonterminal(std::string name, bool lexical, bool repetition = false)
+    {
+        auto const id = static_cast<Id>(g_.nonterminals.size());
+        auto const symbol = static_cast<Id>(g_.symbols.size());
+        g_.symbols.push_back({Kind::nonterminal, false, {}, {}, id});
+        g_.nonterminals.push_back({std::move(name), lexical, repetition, symbol, {}, none});
+        return id;
+    }
+
+    Id terminal(Grammar::Symbol symbol)
+    {
+        if (auto const found = terminals_.find(symbol); found != terminals_.end()) return found->second;
+        auto const id = static_cast<Id>(g_.symbols.size());
+        terminals_.emplace(symbol, id);
+        g_.symbols.push_back(std::move(symbol));
+        return id;
+    }
+
+    void rule(Id lhs, std::vector<Id> rhs, std::size_t alternative)
+    {
+        auto const id = static_cast<Id>(g_.rules.size());
+        auto const dotted = static_cast<Id>(g_.next.size());
+        for (auto const symbol : rhs) {
+            g_.rule_of.push_back(id);
+            g_.next.push_back(symbol);
+        }
+        g_.rule_of.push_back(id);
+        g_.next.push_back(none);
+        g_.rules.push_back({lhs, std::move(rhs), static_cast<Id>(alternative), dotted});
+        g_.nonterminals[lhs].rules.push_back(id);
+    }
+
+    Id start_of(Id nonterminal)
+    {
+        if (g_.nonterminals[nonterminal].start == none) {
+            auto const start = this->nonterminal({}, g_.nonterminals[nonterminal].lexical);
+            rule(start, {g_.nonterminals[nonterminal].symbol}, 0);
+            g_.nonterminals[nonterminal].start = start;
+        }
+        return g_.nonterminals[nonterminal].start;
+    }
+
+    std::vector<Id> term(Term const& t, bool lexical)
+    {
+        std::vector<Id> ret;
+        factor(*ast_cast<Factor>(t.factor), lexical, ret);
+        for (auto const& f : t.factors) factor(*ast_cast<Factor>(f), lexical, ret);
+        return ret;
+    }
+
+    std::vector<Term const*> terms(Expression const& e)
+    {
+        std::vector<Term const*> ret{ast_cast<Term>(e.term)};
+        for (auto const& t : e.terms) ret.push_back(ast_cast<Term>(t));
+        return ret;
+    }
+
+    void factor(Factor const& f, bool lexical, std::vector<Id>& out)
+    {
+        if (f.type == Factor::Type::id_v) {
+            auto const& name = ast_cast<Identifier>(f.value)->value;
+            if (auto const found = productions_.find(name); found != productions_.end()) {
+                auto const n = found->second;
+                if (!lexical && g_.nonterminals[n].lexical) {
+                    start_of(n);
+                    out.push_back(terminal({Kind::token, true, {}, {}, n}));
+                } else {
+                    out.push_back(g_.nonterminals[n].symbol);
+                }
+            } else if (auto const b = builtin(name)) {
+                out.push_back(terminal({Kind::builtin, !lexical, *b, {}, none}));
+            } else {
+                throw std::invalid_argument{"undefined identifier: " + name};
+            }
+            return;
+        } else if (f.type == Factor::Type::li_v) {
+            out.push_back(terminal({Kind::literal, !lexical, {}, ast_cast<Literal>(f.value)->value, none}));
+            return;
+        }
+
+        auto const ts = terms(*ast_cast<Expression>(f.value));
+        if (f.type == Factor::Type::gr_v && ts.size() == 1) {
+            auto const symbols = term(*ts.front(), lexical);
+            out.insert(out.end(), symbols.begin(), symbols.end());
+            return;
+        }
+
+        // Groups and optional parts try their alternatives in order, and
+        // repetitions grow to the left, so that they never nest deeper than
+        // the grammar does.
+        auto const n = nonterminal({}, lexical, f.type == Factor::Type::re_v);
+        if (f.type == Factor::Type::re_v) rule(n, {}, 0);
+        for (std::size_t i = 0; i != ts.size(); ++i) {
+            auto symbols = term(*ts[i], lexical);
+            if (f.type == Factor::Type::re_v) symbols.insert(symbols.begin(), g_.nonterminals[n].symbol);
+            rule(n, std::move(symbols), i);
+        }
+        if (f.type == Factor::Type::op_v) rule(n, {}, ts.size());
+        out.push_back(g_.nonterminals[n].symbol);
+    }
+
+public:
+
+    explicit Compiler(Grammar& g)
+        : g_{g}
+    {}
+
+    void compile(Syntax const& syntax, std::string_view start, Earley_options const& options)
+    {
+        std::vector<std::pair<Id, Expression const*>> bodies;
+        for (auto const& p : syntax.productions) {
+            auto const& production = *ast_cast<Production>(p);
+            auto const& name = ast_cast<Identifier>(production.identifier)->value;
+            if (productions_.contains(name)) continue;
+            auto const n = nonterminal(name, options.lexical.contains(name));
+            productions_.emplace(name, n);
+            bodies.emplace_back(n, ast_cast<Expression>(production.expression));
+        }
+        for (auto const& [n, body] : bodies) {
+            auto const ts = terms(*body);
+            for (std::size_t i = 0; i != ts.size(); ++i) rule(n, term(*ts[i], g_.nonterminals[n].lexical), i);
+        }
+
+        auto const found = productions_.find(start);
+        if (found == productions_.end()) {
+            throw std::invalid_argument{"undefined start production: " + std::string{start}};
+        }
+        g_.start = start_of(found->second);
+        g_.lexical_start = g_.nonterminals[found->second].lexical;
+    }
+};
+
+class Chart;
+
+// What the charts of a parse share: the charts of the nested parses of lexical
+// productions are reused, one for each level of nesting.
+struct Context
+{
+    Grammar const& grammar;
+    std::string_view input;
+    std::vector<std::unique_ptr<Chart>> nested = {};
+    std::size_t depth = 0;
+};
+
+// Leo's shortcut for a nonterminal in a set: if the only item there waiting
+// for it is a rule that it ends, completing the nonterminal completes that
+// rule, and so on up a chain of right recursion to the top item.
+struct Leo
+{
+    enum class State : std::uint8_t { computing, missing, found };
+
+    Id nonterminal;
+    State state;
+    Item top;
+    Item penultimate;
+    // The nonterminals that the rules from here to the top complete, sorted.
+    std::shared_ptr<std::vector<Id> const> chain;
+};
+
+struct Set
+{
+    Id position = 0;
+    Id whitespace_end = none;
+    std::vector<Item> items;
+    // Indexes items once there are more than a few.
+    std::unordered_set<std::uint64_t> index;
+    // The terminals scanned into this set and the positions they were
+    // scanned from.
+    std::vector<std::pair<Id, Id>> arrivals;
+    // The nonterminals completed through a Leo shortcut and their origins,
+    // from which the skipped items are restored for building the tree. A
+    // shortcut is removed once its items have been restored.
+    std::vector<std::pair<Id, Id>> shortcuts;
+    // The nonterminals completed here and their origins, sorted, once the
+    // set has been prepared.
+    std::vector<std::pair<Id, Id>> completed;
+    // The restored items, by key, and where their last symbol starts.
+    std::unordered_map<std::uint64_t, Id> splits;
+    bool prepared = false;
+    // The items waiting for each nonterminal, by index. Sorted once the set
+    // is finished.
+    std::vector<std::pair<Id, Id>> waiting;
+    std::vector<Leo> leo;
+    // The longest matches of lexical productions after the whitespace here.
+    std::vector<std::pair<Id, Id>> tokens;
+
+    void reset(Id at)
+    {
+        position = at;
+        whitespace_end = none;
+        items.clear();
+        index.clear();
+        arrivals.clear();
+        shortcuts.clear();
+        completed.clear();
+        splits.clear();
+        prepared = false;
+        waiting.clear();
+        leo.clear();
+        tokens.clear();
+    }
+};
+
+class Chart
+{
+    Context& cx_;
+    Grammar const& g_;
+    Id base_;
+    Id furthest_;
+    // Sets are kept for reuse when the chart is reset, and only the first
+    // used_ of them are in use.
+    std::deque<Set> sets_;
+    std::size_t used_ = 0;
+    // The set of each position from the base, or none.
+    std::vector<Id> slots_;
+    // The position at which a nonterminal was last predicted, or completed
+    // without consuming input, in the parse numbered generation_.
+    std::uint64_t generation_ = 0;
+    std::vector<std::uint64_t> predicted_at_;
+    std::vector<std::uint64_t> empty_at_;
+
+    // The links of a Leo chain whose shortcuts are being computed.
+    struct Link
+    {
+        Set* set;
+        std::size_t index;
+        Item item;
+    };
+    std::vector<Link> links_;
+
+    std::uint64_t stamp(Id position) const { return generation_ << 32 | position; }
+
+public:
+
+    Chart(Context& cx, Id base)
+        : cx_{cx}, g_{cx.grammar}, base_{base}, furthest_{base},
+          predicted_at_(cx.grammar.nonterminals.size(), UINT64_MAX), empty_at_(cx.grammar.nonterminals.size(), UINT64_MAX)
+    {}
+
+    void reset(Id base)
+    {
+        for (std::size_t i = 0; i != used_; ++i) slots_[sets_[i].position - base_] = none;
+        used_ = 0;
+        base_ = furthest_ = base;
+        ++generation_;
+    }
+
+    Context const& context() const { return cx_; }
+
+    Set* find(Id position)
+    {
+        auto const slot = position - base_;
+        if (position < base_ || slot >= slots_.size() || slots_[slot] == none) return nullptr;
+        return &sets_[slots_[slot]];
+    }
+
+    Set& at(Id position)
+    {
+        if (auto* s = find(position)) return *s;
+        auto const slot = position - base_;
+        if (slot >= slots_.size()) slots_.resize(slot + 1, none);
+        slots_[slot] = static_cast<Id>(used_);
+        furthest_ = std::max(furthest_, position);
+        if (used_ == sets_.size()) sets_.emplace_back();
+        auto& s = sets_[used_++];
+        s.reset(position);
+        return s;
+    }
+
+    bool contains(Set const& s, Item x) const
+    {
+        if (!s.index.empty()) return s.index.contains(key(x));
+        return std::ranges::find(s.items, x) != s.items.end();
+    }
+
+    bool add(Set& s, Item x)
+    {
+        if (contains(s, x)) return false;
+        count_step();
+        s.items.push_back(x);
+        if (!s.index.empty()) {
+            s.index.insert(key(x));
+        } else if (s.items.size() > 16) {
+            for (auto const y : s.items) s.index.insert(key(y));
+        }
+        return true;
+    }
+
+    Id whitespace_end(Set& s)
+    {
+        if (s.whitespace_end == none) {
+            auto end = s.position;
+            while (end != cx_.input.size() && std::isspace(static_cast<unsigned char>(cx_.input[end]))) ++end;
+            s.whitespace_end = end;
+        }
+        return s.whitespace_end;
+    }
+
+    // Parses from the base with the start nonterminal of a production, and
+    // returns the last position at which it was completed, or none.
+    Id parse(Id start)
+    {
+        auto const dotted = g_.rules[g_.nonterminals[start].rules.front()].dotted;
+        add(at(base_), {dotted, base_});
+        Item const done{dotted + 1, base_};
+        Id last = none;
+        for (auto p = base_; p <= furthest_; ++p) {
+            if (auto* s = find(p)) {
+                process(*s);
+                if (contains(*s, done)) last = p;
+            }
+        }
+        return last;
+    }
+
+    // Returns Leo's shortcut for a nonterminal in a finished set. The chain
+    // above it is followed with a loop, not recursion, and the shortcut of
+    // each link is memoized in its set.
+    std::optional<Leo> leo(Set& s, Id nonterminal)
+    {
+        links_.clear();
+        std::optional<Leo> above;
+        for (auto* link = &s;;) {
+            if (auto const memo = std::ranges::find(link->leo, nonterminal, &Leo::nonterminal); memo != link->leo.end()) {
+                if (memo->state == Leo::State::found) above = *memo;
+                break;
+            }
+            auto const [lo, hi] = std::ranges::equal_range(link->waiting, nonterminal, {}, &std::pair<Id, Id>::first);
+            auto const item = lo != hi ? link->items[lo->second] : Item{};
+            auto const& rule = g_.rules[g_.rule_of[item.dotted]];
+            if (hi - lo != 1 || item.dotted - rule.dotted + 1 != rule.rhs.size()) {
+                link->leo.push_back({nonterminal, Leo::State::missing, {}, {}, {}});
+                break;
+            }
+            links_.push_back({link, link->leo.size(), item});
+            link->leo.push_back({nonterminal, Leo::State::computing, {}, {}, {}});
+            link = find(item.origin);
+            nonterminal = rule.lhs;
+        }
+
+        for (auto i = links_.rbegin(); i != links_.rend(); ++i) {
+            auto& l = i->set->leo[i->index];
+            auto const lhs = g_.lhs(i->item.dotted);
+            auto chain = above ? above->chain : nullptr;
+            if (!chain || !std::ranges::binary_search(*chain, lhs)) {
+                auto ids = chain ? *chain : std::vector<Id>{};
+                ids.insert(std::ranges::upper_bound(ids, lhs), lhs);
+                chain = std::make_shared<std::vector<Id> const>(std::move(ids));
+            }
+            l = {l.nonterminal, Leo::State::found, above ? above->top : Item{i->item.dotted + 1, i->item.origin}, i->item, std::move(chain)};
+            above = l;
+        }
+        return above;
+    }
+
+    // Sorts the nonterminals completed in a finished set and the arrivals of
+    // terminals for looking them up.
+    void prepare(Set& s)
+    {
+        if (s.prepared) return;
+        s.prepared = true;
+        for (auto const item : s.items) {
+            if (g_.next[item.dotted] == none) s.completed.emplace_back(g_.lhs(item.dotted), item.origin);
+        }
+        std::ranges::sort(s.completed);
+        std::ranges::sort(s.arrivals);
+    }
+
+    // Adds the completed items of a nonterminal that Leo shortcuts skipped
+    // back to a finished set, with the rest of the chains they are on. A chain
+    // that joins one restored before stops there, so each item is restored
+    // once, and only the sets that the tree needs such items from are restored.
+    void restore(Set& s, Id nonterminal)
+    {
+        prepare(s);
+        auto const size = s.completed.size();
+        for (std::size_t i = 0; i != s.shortcuts.size();) {
+            auto const [shortcut, origin] = s.shortcuts[i];
+            auto l = leo(*find(origin), shortcut);
+            if (l && !std::ranges::binary_search(*l->chain, nonterminal)) {
+                ++i;
+                continue;
+            }
+            for (auto split = origin; l; l = leo(*find(split), g_.lhs(l->penultimate.dotted))) {
+                Item const item{l->penultimate.dotted + 1, l->penultimate.origin};
+                if (s.splits.contains(key(item))) break;
+                if (add(s, item)) {
+                    s.splits.emplace(key(item), split);
+                    s.completed.emplace_back(g_.lhs(item.dotted), item.origin);
+                }
+                split = item.origin;
+            }
+            s.shortcuts[i] = s.shortcuts.back();
+            s.shortcuts.pop_back();
+        }
+        if (s.completed.size() != size) std::ranges::sort(s.completed);
+    }
+
+    // Where the last symbol of an item that was restored to a set starts, or
+    // none if the item was not restored.
+    Id split(Set& s, Item item)
+    {
+        restore(s, g_.lhs(item.dotted));
+        auto const found = s.splits.find(key(item));
+        return found != s.splits.end() ? found->second : none;
+    }
+
+private:
+
+    void process(Set& s)
+    {
+        for (std::size_t x = 0; x != s.items.size(); ++x) {
+            auto const item = s.items[x];
+            auto const symbol = g_.next[item.dotted];
+            if (symbol == none) {
+                complete(s, item);
+            } else if (g_.is_nonterminal(symbol)) {
+                predict(s, g_.symbols[symbol].nonterminal, item);
+            } else {
+                scan(s, symbol, item);
+            }
+        }
+        for (Id x = 0; x != s.items.size(); ++x) {
+            if (auto const symbol = g_.next[s.items[x].dotted]; symbol != none && g_.is_nonterminal(symbol)) {
+                s.waiting.emplace_back(g_.symbols[symbol].nonterminal, x);
+            }
+        }
+        std::ranges::sort(s.waiting);
+    }
+
+    void predict(Set& s, Id nonterminal, Item item)
+    {
+        if (predicted_at_[nonterminal] != stamp(s.position)) {
+            predicted_at_[nonterminal] = stamp(s.position);
+            for (auto const r : g_.nonterminals[nonterminal].rules) add(s, {g_.rules[r].dotted, s.position});
+        }
+        if (empty_at_[nonterminal] == stamp(s.position)) add(s, {item.dotted + 1, item.origin});
+    }
+
+    void complete(Set& s, Item item)
+    {
+        auto const nonterminal = g_.lhs(item.dotted);
+        if (item.origin == s.position) {
+            // Items that wait for the nonterminal later are advanced when
+            // they predict it.
+            if (empty_at_[nonterminal] == stamp(s.position)) return;
+            empty_at_[nonterminal] = stamp(s.position);
+            for (std::size_t x = 0; x != s.items.size(); ++x) {
+                auto const waiting = s.items[x];
+                if (auto const symbol = g_.next[waiting.dotted]; symbol == g_.nonterminals[nonterminal].symbol) {
+                    add(s, {waiting.dotted + 1, waiting.origin});
+                }
+            }
+            return;
+        }
+
+        auto& origin = *find(item.origin);
+        if (auto const l = leo(origin, nonterminal)) {
+            add(s, l->top);
+            if (std::ranges::find(s.shortcuts, std::pair{nonterminal, item.origin}) == s.shortcuts.end()) {
+                s.shortcuts.emplace_back(nonterminal, item.origin);
+            }
+            return;
+        }
+        auto const [lo, hi] = std::ranges::equal_range(origin.waiting, nonterminal, {}, &std::pair<Id, Id>::first);
+        for (auto w = lo; w != hi; ++w) {
+            auto const waiting = origin.items[w->second];
+            add(s, {waiting.dotted + 1, waiting.origin});
+        }
+    }
+
+    void scan(Set& s, Id symbol, Item item)
+    {
+        auto const& terminal = g_.symbols[symbol];
+        auto const end = match(s, terminal, terminal.skip ? whitespace_end(s) : s.position);
+        if (end == none) return;
+        auto& target = end == s.position ? s : at(end);
+        add(target, {item.dotted + 1, item.origin});
+        target.arrivals.emplace_back(symbol, s.position);
+    }
+
+    Id match(Set& s, Grammar::Symbol const& terminal, Id position)
+    {
+        auto const rest = cx_.input.substr(position);
+        auto const length = [&](std::size_t n){ return static_cast<Id>(position + n); };
+        switch (terminal.kind) {
+            case Kind::literal:
+                return rest.starts_with(terminal.literal) ? length(terminal.literal.size()) : none;
+            case Kind::token:
+                return longest_match(s, terminal.nonterminal, position);
+            default:
+                break;
+        }
+
+        if (terminal.builtin == Builtin::newline) {
+            return rest.starts_with("\r\n") ? length(2) : rest.starts_with('\n') ? length(1) : none;
+        }
+        auto const ch = code_point(rest);
+        if (!ch) return none;
+        auto const x = ch->first;
+        bool matched = false;
+        switch (terminal.builtin) {
+            case Builtin::letter: matched = is_letter(x); break;
+            case Builtin::lower: matched = is_lower(x); break;
+            case Builtin::upper: matched = is_upper(x); break;
+            case Builtin::digit: matched = is_digit(x); break;
+            case Builtin::alphanum: matched = is_letter(x) || is_digit(x); break;
+            case Builtin::character: matched = x != '"'; break;
+            case Builtin::newline: break;
+        }
+        return matched ? length(rest.size() - ch->second.size()) : none;
+    }
+
+    // The end of the longest match of a lexical production after the
+    // whitespace at a set, found by a parse of its own.
+    Id longest_match(Set& s, Id nonterminal, Id position)
+    {
+        for (auto const& [n, end] : s.tokens) {
+            if (n == nonterminal) return end;
+        }
+        if (cx_.nested.size() == cx_.depth) cx_.nested.push_back(std::make_unique<Chart>(cx_, position));
+        auto& chart = *cx_.nested[cx_.depth];
+        chart.reset(position);
+        ++cx_.depth;
+        auto const end = chart.parse(g_.nonterminals[nonterminal].start);
+        --cx_.depth;
+        s.tokens.emplace_back(nonterminal, end);
+        return end;
+    }
+};
+
+// Builds a parse tree from a chart, from the end of the input back to the
+// start, and prefers the derivations that Earley_parser documents.
+class Tree_builder
+{
+    Chart& chart_;
+    Grammar const& g_;
+    std::string_view input_;
+    // The nonterminals being built, to break cycles of rules that match
+    // the same input.
+    std::set<std::tuple<Id, Id, Id>> open_;
+
+    // The positions from which a symbol can have been matched up to a set,
+    // latest first.
+    std::vector<Id> origins(Id symbol, Set& s)
+    {
+        if (g_.is_nonterminal(symbol)) {
+            chart_.restore(s, g_.symbols[symbol].nonterminal);
+        } else {
+            chart_.prepare(s);
+        }
+        auto const& from = g_.is_nonterminal(symbol) ? s.completed : s.arrivals;
+        auto const [lo, hi] = std::ranges::equal_range(
+            from, g_.is_nonterminal(symbol) ? g_.symbols[symbol].nonterminal : symbol, {}, &std::pair<Id, Id>::first
+        );
+        std::vector<Id> ret;
+        for (auto x = hi; x != lo; --x) {
+            if (ret.empty() || ret.back() != std::prev(x)->second) ret.push_back(std::prev(x)->second);
+        }
+        return ret;
+    }
+
+    // The input between two positions without the whitespace at its start.
+    std::string_view trimmed(Id from, Id to)
+    {
+        while (from != to && std::isspace(static_cast<unsigned char>(input_[from]))) ++from;
+        return input_.substr(from, to - from);
+    }
+
+    std::string_view text(Grammar::Nonterminal const& n, Id from, Id to)
+    {
+        return n.lexical ? input_.substr(from, to - from) : trimmed(from, to);
+    }
+
+    // A call of node(), walk() or repetition(), kept on a stack of its own
+    // rather than the machine's so that the depth of a tree is not limited.
+    struct Frame
+    {
+        enum class Kind : std::uint8_t { node, walk, repetition };
+
+        Kind kind = Kind::node;
+        // The nonterminal of a node or repetition, or the rule of a walk.
+        Id nonterminal = none;
+        Grammar::Rule const* rule = nullptr;
+        // Where a node or repetition starts and ends, or the origin and end of
+        // a walk.
+        Id from = none;
+        Id to = none;
+        std::vector<Parse_node>* out = nullptr;
+        // The dot of a walk, the symbol it stops at, and where it sets the
+        // position that symbol ends.
+        std::size_t d = 0;
+        std::size_t first = 0;
+        Id* begin = nullptr;
+        // The call this frame waits for, 0 before the first.
+        std::uint8_t stage = 0;
+        // The rule or the position being tried, and the size of out before it.
+        std::size_t next = 0;
+        std::size_t mark = 0;
+        std::vector<Id> candidates;
+        Id end = none;
+        Parse_node production;
+    };
+
+    std::deque<Frame> frames_;
+    // What the last frame to return returned.
+    bool returned_ = false;
+
+    void call_node(Id nonterminal, Id from, Id to, std::vector<Parse_node>& out)
+    {
+        auto& f = frames_.emplace_back();
+        f.kind = g_.nonterminals[nonterminal].repetition ? Frame::Kind::repetition : Frame::Kind::node;
+        f.nonterminal = nonterminal;
+        f.from = from;
+        f.to = to;
+        f.out = &out;
+    }
+
+    // Adds the symbols of a rule before the dot at d, which ends at a
+    // position, to out, last first. Stops at the symbol numbered first and
+    // sets begin to where it ends.
+    void call_walk(Grammar::Rule const& rule, std::size_t d, std::size_t first, Id origin, Id end, Id& begin, std::vector<Parse_node>& out)
+    {
+        auto& f = frames_.emplace_back();
+        f.kind = Frame::Kind::walk;
+        f.rule = &rule;
+        f.from = origin;
+        f.to = end;
+        f.out = &out;
+        f.d = d;
+        f.first = first;
+        f.begin = &begin;
+    }
+
+    static void erase(std::vector<Parse_node>& out, std::size_t mark)
+    {
+        out.erase(out.begin() + static_cast<std::ptrdiff_t>(mark), out.end());
+    }
+
+    // Resumes a node, which tries its rules in order. Returns whether it
+    // matched, or nothing while it waits for a call it made.
+    std::optional<bool> resume_node(Frame& f)
+    {
+        auto const& n = g_.nonterminals[f.nonterminal];
+        auto& s = *chart_.find(f.to);
+        if (f.stage == 0) {
+            if (!open_.emplace(f.nonterminal, f.from, f.to).second) return false;
+            chart_.restore(s, f.nonterminal);
+            f.stage = 1;
+        } else if (returned_) {
+            if (!n.name.empty()) {
+                std::ranges::reverse(f.production.children);
+                f.out->push_back(std::move(f.production));
+            }
+            open_.erase({f.nonterminal, f.from, f.to});
+            return true;
+        } else {
+            erase(*f.out, f.mark);
+            ++f.next;
+        }
+        for (; f.next != n.rules.size(); ++f.next) {
+            auto const& rule = g_.rules[n.rules[f.next]];
+            if (!chart_.contains(s, {static_cast<Id>(rule.dotted + rule.rhs.size()), f.from})) continue;
+            f.mark = f.out->size();
+            auto* out = f.out;
+            if (!n.name.empty()) {
+                f.production = {n.name, rule.alternative, text(n, f.from, f.to), {}};
+                out = &f.production.children;
+            }
+            call_walk(rule, rule.rhs.size(), 0, f.from, f.to, f.end, *out);
+            return std::nullopt;
+        }
+        open_.erase({f.nonterminal, f.from, f.to});
+        return false;
+    }
+
+    // Resumes a walk, which tries the positions the symbol before the dot can
+    // have been matched from, latest first, and the rest of the rule before it.
+    std::optional<bool> resume_walk(Frame& f)
+    {
+        auto const& rule = *f.rule;
+        if (f.stage == 0 && f.d == f.first) {
+            *f.begin = f.to;
+            return f.first != 0 || f.to == f.from;
+        }
+        auto const symbol = rule.rhs[f.d - 1];
+        if (f.stage == 0) {
+            auto& s = *chart_.find(f.to);
+            auto const split = f.d == rule.rhs.size() ? chart_.split(s, {static_cast<Id>(rule.dotted + f.d), f.from}) : none;
+            f.candidates = split != none ? std::vector<Id>{split} : origins(symbol, s);
+            f.stage = 1;
+        } else if (f.stage == 2 && returned_) {
+            // The symbol matched; the rest of the rule ends where it starts.
+            call_walk(rule, f.d - 1, f.first, f.from, f.candidates[f.next], *f.begin, *f.out);
+            f.stage = 3;
+            return std::nullopt;
+        } else if (returned_) {
+            return true;
+        } else {
+            erase(*f.out, f.mark);
+            ++f.next;
+        }
+        Item const prefix{static_cast<Id>(rule.dotted + f.d - 1), f.from};
+        for (; f.next != f.candidates.size(); ++f.next) {
+            auto const from = f.candidates[f.next];
+            if (from < f.from) continue;
+            if (f.d == 1 ? from != f.from : !(chart_.find(from) && chart_.contains(*chart_.find(from), prefix))) continue;
+            f.mark = f.out->size();
+            auto const& x = g_.symbols[symbol];
+            if (x.kind == Kind::nonterminal) {
+                call_node(x.nonterminal, from, f.to, *f.out);
+                f.stage = 2;
+            } else {
+                if (x.kind == Kind::token) f.out->push_back({g_.nonterminals[x.nonterminal].name, 0, trimmed(from, f.to), {}});
+                call_walk(rule, f.d - 1, f.first, f.from, from, *f.begin, *f.out);
+                f.stage = 3;
+            }
+            return std::nullopt;
+        }
+        return false;
+    }
+
+    // Resumes a repetition, which is built from the end, a repeated part at a
+    // time.
+    std::optional<bool> resume_repetition(Frame& f)
+    {
+        auto const& n = g_.nonterminals[f.nonterminal];
+        if (f.stage != 0 && returned_ && f.end < f.to) {
+            f.to = f.end;
+            f.next = 0;
+        } else if (f.stage != 0) {
+            erase(*f.out, f.mark);
+            ++f.next;
+        }
+        f.stage = 1;
+        if (f.from == f.to) return true;
+        auto& s = *chart_.find(f.to);
+        chart_.restore(s, f.nonterminal);
+        for (; f.next != n.rules.size(); ++f.next) {
+            auto const& rule = g_.rules[n.rules[f.next]];
+            if (rule.rhs.empty() || !chart_.contains(s, {static_cast<Id>(rule.dotted + rule.rhs.size()), f.from})) continue;
+            f.mark = f.out->size();
+            f.end = none;
+            call_walk(rule, rule.rhs.size(), 1, f.from, f.to, f.end, *f.out);
+            return std::nullopt;
+        }
+        return false;
+    }
+
+public:
+
+    explicit Tree_builder(Chart& chart)
+        : chart_{chart}, g_{chart.context().grammar}, input_{chart.context().input}
+    {}
+
+    // Adds what a nonterminal matched between two positions to out: a node
+    // for a production, or the nodes inside a group, optional or repeated
+    // part. Nodes are added last first.
+    bool node(Id nonterminal, Id from, Id to, std::vector<Parse_node>& out)
+    {
+        call_node(nonterminal, from, to, out);
+        while (!frames_.empty()) {
+            auto& f = frames_.back();
+            std::optional<bool> done;
+            switch (f.kind) {
+                case Frame::Kind::node: done = resume_node(f); break;
+                case Frame::Kind::walk: done = resume_walk(f); break;
+                case Frame::Kind::repetition: done = resume_repetition(f); break;
+            }
+            if (done) {
+                frames_.pop_back();
+                returned_ = *done;
+            }
+        }
+        return returned_;
+    }
+};
+
+Ast syntax_tree(Parse_node const& x);
+
+Ast expression_tree(Parse_node const& x)
+{
+    std::vector<Ast> terms;
+    for (std::size_t i = 1; i != x.children.size(); ++i) terms.push_back(syntax_tree(x.children[i]));
+    return Ast{Expression{syntax_tree(x.children.front()), std::move(terms)}};
+}
+
+Ast syntax_tree(Parse_node const& x)
+{
+    if (x.production == "identifier") {
+        return Ast{Identifier{std::string{x.text}}};
+    } else if (x.production == "literal") {
+        std::string value;
+        for (std::size_t i = 1; i + 1 < x.text.size(); ++i) {
+            value += x.text[i];
+            if (x.text[i] == '"') ++i;
+        }
+        return Ast{Literal{std::move(value)}};
+    } else if (x.production == "factor") {
+        constexpr Factor::Type types[] = {
+            Factor::Type::id_v, Factor::Type::li_v, Factor::Type::gr_v, Factor::Type::op_v, Factor::Type::re_v,
+        };
+        return Ast{Factor{types[x.alternative], syntax_tree(x.children.front())}};
+    } else if (x.production == "term") {
+        std::vector<Ast> factors;
+        for (std::size_t i = 1; i != x.children.size(); ++i) factors.push_back(syntax_tree(x.children[i]));
+        return Ast{Term{syntax_tree(x.children.front()), std::move(factors)}};
+    } else if (x.production == "expression") {
+        return expression_tree(x);
+    } else if (x.production == "production") {
+        return Ast{Production{syntax_tree(x.children[0]), syntax_tree(x.children[1])}};
+    } else {
+        std::vector<Ast> productions;
+        for (auto const& child : x.children) productions.push_back(syntax_tree(child));
+        return Ast{Syntax{std::move(productions)}};
+    }
+}
+
+} // namespace
+
+Earley_parser::Earley_parser(Ast const& syntax, std::string_view start, Earley_options const& options)
+{
+    auto grammar = std::make_shared<Grammar>();
+    Compiler{*grammar}.compile(*ast_cast<Syntax>(syntax), start, options);
+    grammar_ = std::move(grammar);
+}
+
+auto Earley_parser::operator()(std::string_view input) const -> Parsed_t<Parse_node>
+{
+    if (input.size() >= none) throw std::length_error{"input too long for Earley_parser"};
+    Context cx{*grammar_, input};
+    Chart chart{cx, 0};
+    auto const end = chart.parse(grammar_->start);
+    if (end == none) return {};
+
+    std::vector<Parse_node> tree;
+    auto const start = grammar_->rules[grammar_->nonterminals[grammar_->start].rules.front()].rhs.front();
+    if (!Tree_builder{chart}.node(grammar_->symbols[start].nonterminal, 0, end, tree)) return {};
+    auto rest = input.substr(end);
+    if (!grammar_->lexical_start) rest = std::invoke(skip_whitespace, rest)->second;
+    return {{std::move(tree.front()), rest}};
+}
+
+// syntax = {production}.
+auto earley_syntax(std::string_view input) -> Parsed_t<Ast>
+{
+    if (!valid_utf8(input)) return {};
+    static Earley_parser const parser{syntax(earley_self_grammar)->first, "syntax", {{"identifier", "literal"}}};
+    if (auto parsed = parser(input)) {
+        return {{syntax_tree(parsed->first), parsed->second}};
+    }
+    return {};
+}
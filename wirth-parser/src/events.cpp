@@ -0,0 +1,307 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "events.h"
+#include "parser.h"
+#include "utf8.h"
+
+namespace {
+
+// Records events to pass them on later.
+class Event_buffer : public Parse_handler
+{
+    enum class Kind : std::uint8_t
+    {
+        enter_production, exit_production, enter_expression, exit_expression,
+        enter_term, exit_term, enter_factor, exit_factor, identifier, literal
+    };
+
+    struct Event
+    {
+        Kind kind;
+        Factor::Type type;
+        std::string_view text;
+    };
+
+    std::vector<Event> events_;
+
+    void add(Kind kind, Factor::Type type = {}, std::string_view text = {})
+    {
+        events_.push_back(Event{kind, type, text});
+    }
+
+public:
+
+    void enter_production() override { add(Kind::enter_production); }
+    void exit_production() override { add(Kind::exit_production); }
+    void enter_expression() override { add(Kind::enter_expression); }
+    void exit_expression() override { add(Kind::exit_expression); }
+    void enter_term() override { add(Kind::enter_term); }
+    void exit_term() override { add(Kind::exit_term); }
+    void enter_factor(Factor::Type type) override { add(Kind::enter_factor, type); }
+    void exit_factor(Factor::Type type) override { add(Kind::exit_factor, type); }
+    void identifier(std::string_view x) override { add(Kind::identifier, {}, x); }
+    void literal(std::string_view x) override { add(Kind::literal, {}, x); }
+
+    void clear() { events_.clear(); }
+
+    void replay(Parse_handler& handler) const
+    {
+        for (auto const& e : events_) {
+            switch (e.kind) {
+                case Kind::enter_production: handler.enter_production(); break;
+                case Kind::exit_production: handler.exit_production(); break;
+                case Kind::enter_expression: handler.enter_expression(); break;
+                case Kind::exit_expression: handler.exit_expression(); break;
+                case Kind::enter_term: handler.enter_term(); break;
+                case Kind::exit_term: handler.exit_term(); break;
+                case Kind::enter_factor: handler.enter_factor(e.type); break;
+                case Kind::exit_factor: handler.exit_factor(e.type); break;
+                case Kind::identifier: handler.identifier(e.text); break;
+                case Kind::literal: handler.literal(e.text); break;
+            }
+        }
+    }
+};
+
+} // namespace
+
+auto expression_events(std::string_view input, Parse_handler& handler) -> Parsed_t<Unit>;
+
+// term = factor {factor}.
+auto term_events(std::string_view input, Parse_handler& handler) -> Parsed_t<Unit>
+{
+    // A factor that does not match fails before it emits anything.
+    auto const factor = [&handler](std::string_view in)
+    {
+        auto const bracketed = [&handler](char open, char close, Factor::Type type)
+        {
+            return chain(
+                skip_lexeme(symbol(open)),
+                [&handler, close, type](auto)
+                {
+                    handler.enter_factor(type);
+                    return sequence(
+                        [&handler, type](auto, auto){ handler.exit_factor(type); return Unit{}; },
+                        commit([&handler](std::string_view x){ return expression_events(x, handler); }),
+                        commit(symbol(close))
+                    );
+                }
+            );
+        };
+        return
+            lexeme(
+                choice(
+                    sequence(
+                        [&handler](std::string_view id)
+                        {
+                            handler.enter_factor(Factor::Type::id_v);
+                            handler.identifier(id);
+                            handler.exit_factor(Factor::Type::id_v);
+                            return Unit{};
+                        },
+                        identifier_span
+                    ),
+                    sequence(
+                        [&handler](auto, std::string_view li, auto)
+                        {
+                            handler.enter_factor(Factor::Type::li_v);
+                            handler.literal(li);
+                            handler.exit_factor(Factor::Type::li_v);
+                            return Unit{};
+                        },
+                        symbol('"'),
+                        commit(literal_span),
+                        commit(symbol('"'))
+                    ),
+                    bracketed('(', ')', Factor::Type::gr_v),
+                    bracketed('[', ']', Factor::Type::op_v),
+                    bracketed('{', '}', Factor::Type::re_v)
+                )
+            )(in);
+    };
+
+    handler.enter_term();
+    return
+        sequence(
+            [&handler](auto, auto){ handler.exit_term(); return Unit{}; },
+            factor,
+            skip_many(factor)
+        )(input);
+}
+
+// expression = term {"|" term}.
+// A term after "|" that does not match leaves an enter_term behind, but then
+// the "." of the production does not match either, and its events are dropped.
+auto expression_events(std::string_view input, Parse_handler& handler) -> Parsed_t<Unit>
+{
+    auto const term = [&handler](std::string_view in){ return term_events(in, handler); };
+
+    handler.enter_expression();
+    return
+        sequence(
+            [&handler](auto, auto){ handler.exit_expression(); return Unit{}; },
+            term,
+            skip_many(skip_sequence(skip_lexeme(symbol('|')), term))
+        )(input);
+}
+
+// production = identifier "=" expression ".".
+auto production_events(std::string_view input, Parse_handler& handler) -> Parsed_t<Unit>
+{
+    return
+        chain(
+            sequence(
+                [](std::string_view id, auto){ return id; },
+                lexeme(identifier_span),
+                skip_lexeme(symbol('='))
+            ),
+            [&handler](std::string_view id)
+            {
+                handler.enter_production();
+                handler.identifier(id);
+                return sequence(
+                    [&handler](auto, auto){ handler.exit_production(); return Unit{}; },
+                    [&handler](std::string_view x){ return expression_events(x, handler); },
+                    skip_lexeme(symbol('.'))
+                );
+            }
+        )(input);
+}
+
+// syntax = {production}.
+auto parse_events(std::string_view input, Parse_handler& handler) -> Parsed_t<Unit>
+{
+    if (!valid_utf8(input)) return {};
+    handler.enter_syntax();
+
+    // The events of a production are held back until it has matched, as
+    // syntax() backtracks out of a production until it reaches a bracket or a
+    // literal. The buffer is reused for each production.
+    Event_buffer buffer;
+    auto const production = [&handler, &buffer](std::string_view in)
+    {
+        buffer.clear();
+        auto result = production_events(in, buffer);
+        if (result) buffer.replay(handler);
+        return result;
+    };
+    auto result = try_parse(skip_sequence(trivia, skip_many(production)))(input);
+    if (result) handler.exit_syntax();
+    return result;
+}
+
+void Ast_builder::enter_syntax()
+{
+    open_.clear();
+    result_.reset();
+    open_.emplace_back();
+}
+
+void Ast_builder::exit_syntax()
+{
+    result_.emplace(Syntax{std::move(open_.back())});
+    open_.pop_back();
+}
+
+void Ast_builder::enter_production()
+{
+    open_.emplace_back();
+}
+
+void Ast_builder::exit_production()
+{
+    auto xs = std::move(open_.back());
+    open_.pop_back();
+    open_.back().emplace_back(Production{std::move(xs[0]), std::move(xs[1])});
+}
+
+void Ast_builder::enter_expression()
+{
+    open_.emplace_back();
+}
+
+void Ast_builder::exit_expression()
+{
+    auto xs = std::move(open_.back());
+    open_.pop_back();
+    auto first = std::move(xs.front());
+    xs.erase(xs.begin());
+    open_.back().emplace_back(Expression{std::move(first), std::move(xs)});
+}
+
+void Ast_builder::enter_term()
+{
+    open_.emplace_back();
+}
+
+void Ast_builder::exit_term()
+{
+    auto xs = std::move(open_.back());
+    open_.pop_back();
+    auto first = std::move(xs.front());
+    xs.erase(xs.begin());
+    open_.back().emplace_back(Term{std::move(first), std::move(xs)});
+}
+
+void Ast_builder::enter_factor(Factor::Type)
+{
+    open_.emplace_back();
+}
+
+void Ast_builder::exit_factor(Factor::Type type)
+{
+    auto value = std::move(open_.back().front());
+    open_.pop_back();
+    open_.back().emplace_back(Factor{type, std::move(value)});
+}
+
+void Ast_builder::identifier(std::string_view value)
+{
+    open_.back().emplace_back(Identifier{std::string{value}});
+}
+
+void Ast_builder::literal(std::string_view value)
+{
+    std::string st;
+    for (std::size_t i = 0; i != value.size(); ++i) {
+        st += value[i];
+        if (value[i] == '"') ++i;
+    }
+    open_.back().emplace_back(Literal{std::move(st)});
+}
+
+std::optional<Ast> const& Ast_builder::result() const
+{
+    return result_;
+}
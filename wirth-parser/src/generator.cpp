@@ -0,0 +1,332 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "generator.h"
+
+namespace {
+
+// SplitMix64, chosen because its output is fully specified, unlike the
+// distributions of <random>.
+class Random
+{
+    std::uint64_t state_;
+
+public:
+
+    explicit Random(std::uint64_t seed) : state_{seed} {}
+
+    std::uint64_t next()
+    {
+        auto z = (state_ += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    std::size_t below(std::size_t n)
+    {
+        return n == 0 ? 0 : static_cast<std::size_t>(next() % n);
+    }
+
+    bool chance(double p)
+    {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53 < p;
+    }
+};
+
+constexpr std::size_t unbounded = std::numeric_limits<std::size_t>::max();
+
+class Generator
+{
+    Generator_options const& options_;
+    std::ostream& out_;
+    Random random_;
+    std::map<std::string, Ast const*, std::less<>> productions_;
+    std::map<std::string, std::size_t, std::less<>> heights_;
+    std::unordered_map<Term const*, std::size_t> term_heights_;
+    std::string buffer_;
+    std::size_t written_ = 0;
+
+    static Expression const& expression_of(Ast const& x) { return *ast_cast<Expression>(x); }
+
+    static std::string const& name_of(Ast const& x) { return ast_cast<Identifier>(x)->value; }
+
+    // The number of productions that must be entered before a sentence can
+    // end, given the heights of the productions computed so far.
+    std::size_t height(Expression const& e)
+    {
+        auto h = height(*ast_cast<Term>(e.term));
+        for (auto const& t : e.terms) h = std::min(h, height(*ast_cast<Term>(t)));
+        return h;
+    }
+
+    std::size_t height(Term const& t)
+    {
+        auto h = height(*ast_cast<Factor>(t.factor));
+        for (auto const& f : t.factors) h = std::max(h, height(*ast_cast<Factor>(f)));
+        return h;
+    }
+
+    std::size_t height(Factor const& f)
+    {
+        switch (f.type) {
+            case Factor::Type::id_v:
+                if (auto const& name = name_of(f.value); is_builtin(name)) {
+                    return 0;
+                } else {
+                    auto const h = heights_.find(name)->second;
+                    return h == unbounded ? unbounded : h + 1;
+                }
+            case Factor::Type::gr_v:
+                return height(expression_of(f.value));
+            default:
+                return 0;
+        }
+    }
+
+    std::size_t term_height(Term const& t)
+    {
+        auto [it, inserted] = term_heights_.try_emplace(&t, 0);
+        if (inserted) it->second = height(t);
+        return it->second;
+    }
+
+    void emit(std::string_view st)
+    {
+        buffer_ += st;
+        if (buffer_.size() >= 1 << 16) flush();
+    }
+
+    void emit(char ch)
+    {
+        buffer_ += ch;
+        if (buffer_.size() >= 1 << 16) flush();
+    }
+
+    void builtin(std::string_view name)
+    {
+        constexpr std::string_view lower{"abcdefghijklmnopqrstuvwxyz"};
+        constexpr std::string_view upper{"ABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+        constexpr std::string_view digit{"0123456789"};
+        auto const pick = [this](std::string_view set){ emit(set[random_.below(set.size())]); };
+        if (name == "lower") {
+            pick(lower);
+        } else if (name == "upper") {
+            pick(upper);
+        } else if (name == "digit") {
+            pick(digit);
+        } else if (name == "letter") {
+            random_.chance(0.5) ? pick(lower) : pick(upper);
+        } else if (name == "alphanum") {
+            random_.chance(0.8) ? pick(lower) : pick(digit);
+        } else if (name == "newline") {
+            emit('\n');
+        } else {
+            auto const ch = static_cast<char>(' ' + random_.below('~' - ' '));
+            emit(ch == '"' ? '~' : ch);
+        }
+    }
+
+    void production(std::string_view name, std::size_t depth, bool lexical)
+    {
+        lexical = lexical || options_.lexical.contains(name);
+        expression(expression_of(*productions_.find(name)->second), depth + 1, lexical);
+    }
+
+    void expression(Expression const& e, std::size_t depth, bool lexical)
+    {
+        auto const count = 1 + e.terms.size();
+        auto const& term_at = [&](std::size_t i) -> Term const&
+        {
+            return *ast_cast<Term>(i == 0 ? e.term : e.terms[i - 1]);
+        };
+
+        std::size_t chosen = 0;
+        if (depth < options_.max_depth) {
+            chosen = random_.below(count);
+        } else {
+            for (std::size_t i = 1; i != count; ++i) {
+                if (term_height(term_at(i)) < term_height(term_at(chosen))) chosen = i;
+            }
+        }
+        term(term_at(chosen), depth, lexical);
+    }
+
+    void term(Term const& t, std::size_t depth, bool lexical)
+    {
+        factor(*ast_cast<Factor>(t.factor), depth, lexical);
+        for (auto const& f : t.factors) {
+            if (!lexical) emit(options_.separator);
+            factor(*ast_cast<Factor>(f), depth, lexical);
+        }
+    }
+
+    void factor(Factor const& f, std::size_t depth, bool lexical)
+    {
+        auto const open = depth < options_.max_depth;
+        switch (f.type) {
+            case Factor::Type::id_v:
+                if (auto const& name = name_of(f.value); is_builtin(name)) {
+                    builtin(name);
+                } else {
+                    production(name, depth, lexical);
+                }
+                break;
+            case Factor::Type::li_v:
+                emit(ast_cast<Literal>(f.value)->value);
+                break;
+            case Factor::Type::gr_v:
+                expression(expression_of(f.value), depth, lexical);
+                break;
+            case Factor::Type::op_v:
+                if (open && random_.chance(options_.optional_probability)) {
+                    expression(expression_of(f.value), depth, lexical);
+                }
+                break;
+            case Factor::Type::re_v:
+                if (open) {
+                    auto const span = options_.max_repeat - std::min(options_.min_repeat, options_.max_repeat);
+                    auto const n = options_.min_repeat + random_.below(span + 1);
+                    for (std::size_t i = 0; i != n; ++i) {
+                        if (i != 0 && !lexical) emit(options_.separator);
+                        expression(expression_of(f.value), depth, lexical);
+                    }
+                }
+                break;
+        }
+    }
+
+    void flush()
+    {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        written_ += buffer_.size();
+        buffer_.clear();
+    }
+
+public:
+
+    Generator(Generator_options const& options, std::ostream& out)
+        : options_{options}, out_{out}, random_{options.seed}
+    {}
+
+    bool load(Syntax const& syntax)
+    {
+        for (auto const& p : syntax.productions) {
+            auto const* production = ast_cast<Production>(p);
+            productions_.emplace(name_of(production->identifier), &production->expression);
+            heights_.emplace(name_of(production->identifier), unbounded);
+        }
+
+        bool defined = true;
+        for (auto const& p : syntax.productions) {
+            traverse(
+                p,
+                [&](Ast const& x)
+                {
+                    if (auto const* f = ast_cast<Factor>(x); f && f->type == Factor::Type::id_v) {
+                        auto const& name = name_of(f->value);
+                        defined = defined && (is_builtin(name) || productions_.contains(name));
+                    }
+                },
+                [](Ast const&){}
+            );
+        }
+        if (!defined) return false;
+
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (auto& [name, h] : heights_) {
+                if (auto const next = height(expression_of(*productions_.find(name)->second)); next < h) {
+                    h = next;
+                    changed = true;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Whether start and every production it can reach derive a finite
+    // sentence. Below max_depth any alternative can be picked, so one that
+    // never ends must not be reachable at all.
+    bool bounded(std::string_view start) const
+    {
+        if (!productions_.contains(start)) return false;
+        std::set<std::string_view> seen{start};
+        std::vector<std::string_view> pending{start};
+        bool ok = true;
+        while (ok && !pending.empty()) {
+            auto const name = pending.back();
+            pending.pop_back();
+            ok = heights_.find(name)->second != unbounded;
+            traverse(
+                *productions_.find(name)->second,
+                [&](Ast const& x)
+                {
+                    if (auto const* f = ast_cast<Factor>(x); f && f->type == Factor::Type::id_v) {
+                        auto const& id = name_of(f->value);
+                        if (!is_builtin(id) && seen.insert(id).second) pending.push_back(id);
+                    }
+                },
+                [](Ast const&){}
+            );
+        }
+        return ok;
+    }
+
+    bool run(std::string_view start)
+    {
+        if (!bounded(start)) return false;
+        while (written_ + buffer_.size() < options_.size) {
+            production(start, 0, false);
+            emit('\n');
+        }
+        flush();
+        return true;
+    }
+};
+
+}
+
+bool generate(Ast const& syntax, std::string_view start, Generator_options const& options, std::ostream& out)
+{
+    auto const* grammar = ast_cast<Syntax>(syntax);
+    Generator generator{options, out};
+    return grammar && generator.load(*grammar) && generator.run(start);
+}
@@ -25,31 +25,370 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org>
 */
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
+#include <numeric>
+#include <optional>
+#include <set>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "alloc_stats.h"
+#include "analysis.h"
 #include "ast.h"
+#include "codegen.h"
+#include "generator.h"
+#include "json.h"
 #include "parser.h"
+#include "serialize.h"
+#include "stream.h"
+#include "util.h"
+
+// A grammar for the syntax of the grammar itself.
+std::string const self_grammar{
+    "syntax = {production}.\n"
+    "production = identifier \"=\" expression \".\".\n"
+    "expression = term {\"|\" term}.\n"
+    "term = factor {factor}.\n"
+    "factor = identifier | literal\n"
+    "           | \"(\" expression \")\"\n"
+    "           | \"[\" expression \"]\"\n"
+    "           | \"{\" expression \"}\".\n"
+    "literal = \"\"\"\" character {character} \"\"\"\".\n"
+    "identifier = (letter | \"_\") {letter | \"_\" | digit}.\n"
+};
+
+// wirth-parser --generate <bytes> writes random grammars in the shape of the
+// self-describing grammar, to be used as stress input for syntax().
+int generate_main(Generator_options options)
+{
+    options.lexical = {"identifier", "literal"};
+    if (auto const grammar = syntax(self_grammar); grammar && generate(grammar->first, "syntax", options, std::cout)) {
+        return 0;
+    } else {
+        std::cerr << "Error: Could not generate input.\n";
+        return 1;
+    }
+}
 
-int main()
-{
-    std::string test_input{
-        "syntax = {production}.\n"
-        "production = identifier \"=\" expression \".\".\n"
-        "expression = term {\"|\" term}.\n"
-        "term = factor {factor}.\n"
-        "factor = identifier | literal\n"
-        "           | \"(\" expression \")\"\n"
-        "           | \"[\" expression \"]\"\n"
-        "           | \"{\" expression \"}\".\n"
-        "literal = \"\"\"\" character {character} \"\"\"\".\n"
-        "identifier = (letter | \"_\") {letter | \"_\" | digit}.\n"
+// wirth-parser --stream reads a grammar from stdin in chunks and prints the code
+// for each production as soon as it has been read.
+int stream_main()
+{
+    Production_stream stream{
+        [](Ast production){ std::cout << fmt(production, 0) << "\n\n" << std::flush; }
     };
+    char chunk[4096];
+    while (std::cin.read(chunk, sizeof chunk) || std::cin.gcount() > 0) {
+        if (!stream.feed({chunk, static_cast<std::size_t>(std::cin.gcount())})) {
+            std::cout << "Error: Could not parse input.\n";
+            return 1;
+        }
+    }
+    if (!stream.finish()) {
+        std::cout << "Error: Incomplete production at end of input.\n";
+        return 1;
+    }
+    return 0;
+}
 
-    std::cout << "Input:\n------\n" << test_input << '\n';
-    if (auto const& result = syntax(test_input)) {
-        std::cout << "Output:\n-------\n" << fmt(result->first, 0);
+// wirth-parser --recognizer <file> writes a C++ header with a recognizer for
+// each production of the grammar in file.
+// Parses the grammar within a budget of steps and, if given, time, so a grammar
+// that makes the parser backtrack excessively is rejected promptly.
+int recognizer_main(std::string const& file, Recognizer_options const& options,
+                    std::uint64_t max_steps, std::optional<std::chrono::milliseconds> timeout)
+{
+    auto const text = read_file(file);
+    if (!text) {
+        std::cerr << "Error: Could not read " << file << ".\n";
+        return 1;
+    }
+    Parse_budget budget{max_steps};
+    if (timeout) budget.deadline = std::chrono::steady_clock::now() + *timeout;
+    auto const bounded = bounded_parse(syntax, std::string_view{*text}, budget);
+    if (bounded.exhausted) {
+        std::cerr << "Error: Parsing " << file;
+        switch (*bounded.exhausted) {
+            using enum Budget_exhausted::Reason;
+            case steps: std::cerr << " exceeded the budget of " << max_steps << " steps.\n"; break;
+            case deadline: std::cerr << " exceeded the time limit of " << timeout->count() << " ms.\n"; break;
+            case cancelled: std::cerr << " was cancelled.\n"; break;
+        }
+        return 1;
+    }
+    auto const& grammar = bounded.parsed;
+    if (!grammar || !std::ranges::all_of(grammar->second, [](char ch){ return std::isspace(static_cast<unsigned char>(ch)); })) {
+        std::cerr << "Error: Could not parse " << file << ".\n";
+        return 1;
+    } else if (!emit_recognizer(grammar->first, options, std::cout)) {
+        std::cerr << "Error: " << file << " uses an undefined identifier.\n";
+        return 1;
+    }
+    return 0;
+}
+
+// wirth-parser --analyze <file> writes a static analysis of the grammar in file
+// as JSON, and fails if it finds errors, so a build can be gated on it.
+int analyze_main(std::string const& file, std::set<std::string, std::less<>> const& lexical)
+{
+    auto const text = read_file(file);
+    if (!text) {
+        std::cerr << "Error: Could not read " << file << ".\n";
+        return 1;
+    }
+    auto const grammar = syntax(*text);
+    if (!grammar || !std::ranges::all_of(grammar->second, [](char ch){ return std::isspace(static_cast<unsigned char>(ch)); })) {
+        std::cerr << "Error: Could not parse " << file << ".\n";
+        return 1;
+    }
+    auto const analysis = analyze(grammar->first, lexical);
+    write_json(analysis, std::cout);
+    return std::ranges::any_of(analysis.problems, &Grammar_problem::is_error) ? 1 : 0;
+}
+
+struct Bench_options
+{
+    std::size_t warmup = 3;
+    std::size_t iterations = 100;
+    std::vector<std::string> files;
+};
+
+// Prints throughput and latency percentiles in microseconds of a sorted sample.
+void print_timings(std::ostream& out, std::vector<double> const& seconds, std::size_t bytes)
+{
+    auto const percentile = [&](double p)
+    {
+        auto const rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(seconds.size())));
+        return seconds[std::clamp<std::size_t>(rank, 1, seconds.size()) - 1] * 1e6;
+    };
+    auto const total = std::accumulate(seconds.begin(), seconds.end(), 0.0);
+    out << "{\"mb_per_s\": " << static_cast<double>(bytes * seconds.size()) / total / 1e6
+        << ", \"p50_us\": " << percentile(0.5)
+        << ", \"p99_us\": " << percentile(0.99)
+        << ", \"p999_us\": " << percentile(0.999) << '}';
+}
+
+std::optional<long> peak_rss_kb()
+{
+#if defined(__linux__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#elif defined(__APPLE__)
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss / 1024;
+#endif
+    return {};
+}
+
+// wirth-parser --bench runs syntax() and fmt() on each input many times and
+// prints throughput, latency percentiles, allocations and peak RSS as JSON.
+int bench_main(Bench_options const& options)
+{
+    std::vector<std::pair<std::string, std::string>> inputs;
+    if (options.files.empty()) {
+        inputs.emplace_back("self", self_grammar);
+    }
+    for (auto const& file : options.files) {
+        if (auto text = read_file(file)) {
+            inputs.emplace_back(file, std::move(*text));
+        } else {
+            std::cerr << "Error: Could not read " << file << ".\n";
+            return 1;
+        }
+    }
+
+    bool all_parsed = true;
+    std::cout << std::fixed << std::setprecision(3)
+              << "{\n  \"warmup\": " << options.warmup
+              << ",\n  \"iterations\": " << options.iterations
+              << ",\n  \"inputs\": [";
+    for (auto const& [name, text] : inputs) {
+        for (std::size_t i = 0; i != options.warmup; ++i) {
+            if (auto const result = syntax(text)) fmt(result->first, 0);
+        }
+
+        // Per-run counts divided by this give the figures per production.
+        std::size_t productions = 0;
+        if (auto const result = syntax(text)) {
+            if (auto const* grammar = ast_cast<Syntax>(result->first)) productions = grammar->productions.size();
+        }
+
+        alloc_stats_reset();
+        std::vector<double> parse_times, format_times;
+        bool parsed = true;
+        for (std::size_t i = 0; i != options.iterations && parsed; ++i) {
+            using Clock = std::chrono::steady_clock;
+            auto const t0 = Clock::now();
+            auto const result = [&]
+            {
+                Alloc_phase phase{"parse"};
+                return syntax(text);
+            }();
+            auto const t1 = Clock::now();
+            if (!result) {
+                parsed = false;
+                break;
+            }
+            {
+                Alloc_phase phase{"format"};
+                auto const output = fmt(result->first, 0);
+            }
+            auto const t2 = Clock::now();
+            parse_times.push_back(std::chrono::duration<double>(t1 - t0).count());
+            format_times.push_back(std::chrono::duration<double>(t2 - t1).count());
+        }
+        all_parsed = all_parsed && parsed;
+
+        std::cout << (&name == &inputs.front().first ? "\n" : ",\n")
+                  << "    {\n      \"name\": " << json_string(name)
+                  << ",\n      \"bytes\": " << text.size()
+                  << ",\n      \"parsed\": " << (parsed ? "true" : "false")
+                  << ",\n      \"productions\": " << productions;
+        if (parsed && !parse_times.empty()) {
+            std::ranges::sort(parse_times);
+            std::ranges::sort(format_times);
+            std::cout << ",\n      \"parse\": ";
+            print_timings(std::cout, parse_times, text.size());
+            std::cout << ",\n      \"format\": ";
+            print_timings(std::cout, format_times, text.size());
+        }
+        std::cout << ",\n      \"allocations_per_run\": ";
+        if (alloc_stats_enabled() && parsed && !parse_times.empty()) {
+            auto const runs = static_cast<double>(parse_times.size());
+            std::cout << '{';
+            for (auto const& st : alloc_stats()) {
+                if (st.phase == "parse" || st.phase == "format") {
+                    std::cout << (st.phase == "parse" ? "" : ", ") << json_string(st.phase) << ": {\"count\": "
+                              << static_cast<double>(st.count) / runs << ", \"bytes\": "
+                              << static_cast<double>(st.bytes) / runs << ", \"ast_copies\": "
+                              << static_cast<double>(st.copies) / runs << '}';
+                }
+            }
+            std::cout << '}';
+        } else {
+            std::cout << "null";
+        }
+        std::cout << "\n    }";
+    }
+
+    std::cout << "\n  ],\n  \"peak_rss_kb\": ";
+    if (auto const rss = peak_rss_kb()) std::cout << *rss; else std::cout << "null";
+    std::cout << "\n}\n";
+    return all_parsed ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    std::optional<std::filesystem::path> cache;
+    bool report_allocs = false;
+    std::optional<Generator_options> generator;
+    std::optional<Bench_options> bench;
+    std::optional<std::string> recognizer;
+    std::optional<std::string> analysis;
+    Recognizer_options recognizer_options;
+    std::uint64_t max_steps = UINT64_MAX;
+    std::optional<std::chrono::milliseconds> timeout;
+    for (int i = 1; i != argc; ++i) {
+        std::string_view const arg{argv[i]};
+        if (arg == "--stream") {
+            return stream_main();
+        } else if (arg == "--cache" && i + 1 != argc) {
+            // Reuses the parse of an unchanged grammar.
+            cache = argv[++i];
+        } else if (arg == "--generate" && i + 1 != argc) {
+            if (!generator) generator.emplace();
+            generator->size = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && i + 1 != argc) {
+            if (!generator) generator.emplace();
+            generator->seed = std::stoull(argv[++i]);
+        } else if (arg == "--pretty") {
+            // Lays tokens out one per line, indented, like a hand-formatted grammar.
+            if (!generator) generator.emplace();
+            generator->separator = "\n        ";
+        } else if (arg == "--bench") {
+            if (!bench) bench.emplace();
+        } else if (arg == "--warmup" && i + 1 != argc) {
+            if (!bench) bench.emplace();
+            bench->warmup = std::stoull(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 != argc) {
+            if (!bench) bench.emplace();
+            bench->iterations = std::stoull(argv[++i]);
+        } else if (bench && !arg.starts_with("--")) {
+            bench->files.emplace_back(arg);
+        } else if (arg == "--recognizer" && i + 1 != argc) {
+            recognizer = argv[++i];
+        } else if (arg == "--analyze" && i + 1 != argc) {
+            analysis = argv[++i];
+        } else if (arg == "--namespace" && i + 1 != argc) {
+            recognizer_options.name_space = argv[++i];
+        } else if (arg == "--lexical" && i + 1 != argc) {
+            recognizer_options.lexical.emplace(argv[++i]);
+        } else if (arg == "--max-steps" && i + 1 != argc) {
+            max_steps = std::stoull(argv[++i]);
+        } else if (arg == "--timeout-ms" && i + 1 != argc) {
+            timeout = std::chrono::milliseconds{std::stoll(argv[++i])};
+        } else if (arg == "--alloc-report") {
+            report_allocs = true;
+        } else if (arg == "--alloc-productions") {
+            report_allocs = true;
+            alloc_track_details(true);
+        } else {
+            std::cerr << "Usage: wirth-parser [--cache <directory>] [--alloc-report | --alloc-productions]\n"
+                         "       wirth-parser --stream\n"
+                         "       wirth-parser --generate <bytes> [--seed <n>] [--pretty]\n"
+                         "       wirth-parser --bench [--warmup <n>] [--iterations <n>] [<file>...]\n"
+                         "       wirth-parser --recognizer <file> [--namespace <name>] [--lexical <production>]...\n"
+                         "                    [--max-steps <n>] [--timeout-ms <n>]\n"
+                         "       wirth-parser --analyze <file> [--lexical <production>]...\n";
+            return 2;
+        }
+    }
+
+    if (generator) {
+        return generate_main(*generator);
+    } else if (bench) {
+        return bench_main(*bench);
+    } else if (recognizer) {
+        return recognizer_main(*recognizer, recognizer_options, max_steps, timeout);
+    } else if (analysis) {
+        return analyze_main(*analysis, recognizer_options.lexical);
+    }
+
+    std::cout << "Input:\n------\n" << self_grammar << '\n';
+    auto const result = [&]
+    {
+        Alloc_phase phase{"parse"};
+        return cache ? cached_syntax(self_grammar, *cache) : syntax(self_grammar);
+    }();
+    if (result) {
+        std::string output;
+        {
+            Alloc_phase phase{"format"};
+            output = fmt(result->first, 0);
+        }
+        std::cout << "Output:\n-------\n" << output;
     } else {
         std::cout << "Error: Could not parse input.\n";
     }
+
+    if (report_allocs) {
+        if (alloc_stats_enabled()) {
+            alloc_report(std::cerr, self_grammar.size());
+        } else {
+            std::cerr << "Allocation stats are off, configure with -DWIRTH_PARSER_ALLOC_STATS=ON.\n";
+        }
+    }
 }
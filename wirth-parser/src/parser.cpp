@@ -26,9 +26,14 @@ For more information, please refer to <http://unlicense.org>
 */
 
 #include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 
 #include "parser.h"
+#include "alloc_stats.h"
 #include "ast.h"
+#include "utf8.h"
 
 /*
 Syntax Notation
@@ -55,130 +60,255 @@ bols, i.e. literals, are enclosed in quote marks (and, if a quote
 mark appears as a literal itself, it is written twice).
 */
 
+namespace {
+
+// The productions below syntax may throw Committed_failure past the
+// alternatives they commit to. The entry points declared in parser.h catch it.
+namespace committed {
+
+auto production(std::string_view input) -> Parsed_t<Ast>;
+
+auto expression(std::string_view input) -> Parsed_t<Ast>;
+
+auto term(std::string_view input) -> Parsed_t<Ast>;
+
+auto factor(std::string_view input) -> Parsed_t<Ast>;
+
+auto literal(std::string_view input) -> Parsed_t<Ast>;
+
+} // namespace committed
+
+} // namespace
+
 // syntax = {production}.
 auto syntax(std::string_view input) -> Parsed_t<Ast>
 {
-    return
+    Alloc_phase phase{"syntax", true};
+    if (!valid_utf8(input)) return {};
+    static auto const parser =
+        try_parse(
+            sequence(
+                [](auto, auto ps){ return Ast{Syntax{std::move(ps)}}; },
+                trivia,
+                repeat(committed::production)
+            )
+        );
+    return parser(input);
+}
+
+namespace {
+
+// The body of a production, up to the "." that ends it outside of a literal.
+auto production_body(std::string_view input) -> Parsed_t<std::string_view>
+{
+    bool in_literal = false;
+    for (std::size_t i = 0; i != input.size(); ++i) {
+        if (input[i] == '"') {
+            in_literal = !in_literal;
+        } else if (input[i] == '.' && !in_literal) {
+            return {{input.substr(0, i), input.substr(i)}};
+        }
+    }
+    return {};
+}
+
+Ast lazy_expression(std::string_view body)
+{
+    if (auto result = expression(body); result && result->second.empty()) {
+        return std::move(result->first);
+    } else {
+        throw std::invalid_argument{"invalid production body: " + std::string{body}};
+    }
+}
+
+} // namespace
+
+// syntax = {production}, with each expression parsed when it is first accessed.
+auto lazy_syntax(std::string_view input) -> Parsed_t<Ast>
+{
+    Alloc_phase phase{"syntax", true};
+    if (!valid_utf8(input)) return {};
+    static auto const parser =
         sequence(
-            [](auto ps){ return Ast{Syntax{ps}}; },
-            repeat(production)
-        )(input);
+            [](auto, auto ps){ return Ast{Syntax{std::move(ps)}}; },
+            trivia,
+            repeat(
+                sequence(
+                    [](auto id, auto, auto body, auto){ return Ast{Production{std::move(id), Ast{Lazy{body, lazy_expression}}}}; },
+                    lexeme(identifier),
+                    skip_lexeme(symbol('=')),
+                    production_body,
+                    skip_lexeme(symbol('.'))
+                )
+            )
+        );
+    return parser(input);
 }
 
+namespace {
+
+namespace committed {
+
 // production = identifier "=" expression "."
 auto production(std::string_view input) -> Parsed_t<Ast>
 {
-    return
+    Alloc_phase phase{"production", true};
+    static auto const parser =
         sequence(
-            [](auto id, auto, auto ex, auto){ return Ast{Production{id, ex}}; },
-            token(identifier),
-            token(symbol('=')),
+            [](auto id, auto, auto ex, auto){ return Ast{Production{std::move(id), std::move(ex)}}; },
+            lexeme(identifier),
+            skip_lexeme(symbol('=')),
             expression,
-            symbol('.')
-        )(input);
+            skip_lexeme(symbol('.'))
+        );
+    return parser(input);
 }
 
 // expression = term {"|" term}.
 auto expression(std::string_view input) -> Parsed_t<Ast>
 {
-    return
+    Alloc_phase phase{"expression", true};
+    static auto const parser =
         sequence(
-            [](auto te, auto ts){ return Ast{Expression{te, ts}}; },
+            [](auto te, auto ts){ return Ast{Expression{std::move(te), std::move(ts)}}; },
             term,
             repeat(
                 sequence(
                     [](auto, auto te){ return te; },
-                    symbol('|'),
+                    skip_lexeme(symbol('|')),
                     term
                 )
             )
-        )(input);
+        );
+    return parser(input);
 }
 
 // term = factor {factor}.
 auto term(std::string_view input) -> Parsed_t<Ast>
 {
-    return
+    Alloc_phase phase{"term", true};
+    static auto const parser =
         sequence(
-            [](auto fa, auto fs){ return Ast{Term{fa, fs}}; },
+            [](auto fa, auto fs){ return Ast{Term{std::move(fa), std::move(fs)}}; },
             factor,
             repeat(
                 factor
             )
-        )(input);
+        );
+    return parser(input);
 }
 
 // factor = identifier | literal | "(" expression ")" | "[" expression "]" | "{" expression "}".
 auto factor(std::string_view input) -> Parsed_t<Ast>
 {
-    return
-        token(
+    Alloc_phase phase{"factor", true};
+    static auto const parser =
+        lexeme(
             choice(
                 sequence(
-                    [](auto id){ return Ast{Factor{Factor::Type::id_v, id}}; },
+                    [](auto id){ return Ast{Factor{Factor::Type::id_v, std::move(id)}}; },
                     identifier
                 ),
                 sequence(
-                    [](auto li){ return Ast{Factor{Factor::Type::li_v, li}}; },
+                    [](auto li){ return Ast{Factor{Factor::Type::li_v, std::move(li)}}; },
                     literal
                 ),
                 sequence(
-                    [](auto, auto ex, auto){ return Ast{Factor{Factor::Type::gr_v, ex}}; },
-                    symbol('('),
-                    expression,
-                    symbol(')')
+                    [](auto, auto ex, auto){ return Ast{Factor{Factor::Type::gr_v, std::move(ex)}}; },
+                    skip_lexeme(symbol('(')),
+                    commit(expression),
+                    commit(symbol(')'))
                 ),
                 sequence(
-                    [](auto, auto ex, auto){ return Ast{Factor{Factor::Type::op_v, ex}}; },
-                    symbol('['),
-                    expression,
-                    symbol(']')
+                    [](auto, auto ex, auto){ return Ast{Factor{Factor::Type::op_v, std::move(ex)}}; },
+                    skip_lexeme(symbol('[')),
+                    commit(expression),
+                    commit(symbol(']'))
                 ),
                 sequence(
-                    [](auto, auto ex, auto){ return Ast{Factor{Factor::Type::re_v, ex}}; },
-                    symbol('{'),
-                    expression,
-                    symbol('}')
+                    [](auto, auto ex, auto){ return Ast{Factor{Factor::Type::re_v, std::move(ex)}}; },
+                    skip_lexeme(symbol('{')),
+                    commit(expression),
+                    commit(symbol('}'))
                 )
             )
-        )(input);
+        );
+    return parser(input);
 }
 
 // literal = """" character {character} """".
 auto literal(std::string_view input) -> Parsed_t<Ast>
 {
-    return
+    Alloc_phase phase{"literal", true};
+    static auto const parser =
         sequence(
-            [](auto, auto st, auto){ return Ast{Literal{st}}; },
+            [](auto, auto st, auto){ return Ast{Literal{std::move(st)}}; },
             symbol('"'),
-            some(
+            commit(some(
                 choice(
-                    chain(str("\"\""), [](auto){ return unit('"'); }),
+                    sequence([](auto, auto){ return '"'; }, symbol('"'), symbol('"')),
                     satisfy([](char x){ return x != '"'; })
-               )
-           ),
-           symbol('"')
-        )(input);
+                )
+            )),
+            commit(symbol('"'))
+        );
+    return parser(input);
+}
+
+} // namespace committed
+
+} // namespace
+
+auto production(std::string_view input) -> Parsed_t<Ast>
+{
+    static auto const parser = try_parse(committed::production);
+    return parser(input);
+}
+
+auto expression(std::string_view input) -> Parsed_t<Ast>
+{
+    static auto const parser = try_parse(committed::expression);
+    return parser(input);
+}
+
+auto term(std::string_view input) -> Parsed_t<Ast>
+{
+    static auto const parser = try_parse(committed::term);
+    return parser(input);
+}
+
+auto factor(std::string_view input) -> Parsed_t<Ast>
+{
+    static auto const parser = try_parse(committed::factor);
+    return parser(input);
+}
+
+auto literal(std::string_view input) -> Parsed_t<Ast>
+{
+    static auto const parser = try_parse(committed::literal);
+    return parser(input);
 }
 
 // identifier = (letter | "_") {letter | "_" | digit}.
 auto identifier(std::string_view input) -> Parsed_t<Ast>
 {
-    return
+    Alloc_phase phase{"identifier", true};
+    static auto const parser =
         sequence(
-            [](auto ch, auto st){ return Ast{Identifier{std::string(1, ch) + st}}; },
+            [](auto ch, auto st){ std::string id; append_utf8(id, ch); id += st; return Ast{Identifier{std::move(id)}}; },
             (
                 choice(
-                    letter,
-                    symbol('_')
+                    u_letter,
+                    u_symbol('_')
                 )
             ),
             many(
                 choice(
-                    letter,
-                    symbol('_'),
-                    digit
+                    u_letter,
+                    u_symbol('_'),
+                    u_digit
                 )
             )
-        )(input);
+        );
+    return parser(input);
 }
@@ -0,0 +1,427 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WIRTH_PARSER_POSIX 1
+#endif
+
+#include "ast.h"
+#include "parser.h"
+#include "serialize.h"
+
+namespace {
+
+enum class Node_kind : std::uint8_t
+{
+    syntax, production, expression, term, factor, literal, identifier, character
+};
+
+constexpr std::string_view magic{"WSNA"};
+constexpr std::size_t header_size = 48;
+constexpr std::size_t node_size = 12;
+
+void put(std::string& out, std::uint64_t value, std::size_t bytes)
+{
+    for (std::size_t i = 0; i != bytes; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+std::uint64_t get(char const* in, std::size_t bytes)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i != bytes; ++i) {
+        value |= std::uint64_t{static_cast<unsigned char>(in[i])} << (8 * i);
+    }
+    return value;
+}
+
+class Writer
+{
+    std::string nodes_;
+    std::vector<std::uint32_t> children_;
+    std::string pool_;
+    std::unordered_map<std::string, std::uint32_t> strings_;
+    std::uint32_t count_ = 0;
+    std::vector<std::uint32_t> done_;
+    bool failed_ = false;
+
+    std::uint32_t node(Node_kind kind, std::uint8_t sub, std::uint32_t a, std::uint32_t b)
+    {
+        put(nodes_, static_cast<std::uint8_t>(kind), 1);
+        put(nodes_, sub, 1);
+        put(nodes_, 0, 2);
+        put(nodes_, a, 4);
+        put(nodes_, b, 4);
+        return count_++;
+    }
+
+    std::uint32_t string(Node_kind kind, std::string const& value)
+    {
+        auto [it, inserted] = strings_.try_emplace(value, static_cast<std::uint32_t>(pool_.size()));
+        if (inserted) pool_ += value;
+        return node(kind, 0, it->second, static_cast<std::uint32_t>(value.size()));
+    }
+
+    std::uint32_t list(Node_kind kind, std::size_t count)
+    {
+        auto const first = done_.end() - static_cast<std::ptrdiff_t>(count);
+        auto const offset = static_cast<std::uint32_t>(children_.size());
+        children_.insert(children_.end(), first, done_.end());
+        done_.erase(first, done_.end());
+        return node(kind, 0, offset, static_cast<std::uint32_t>(count));
+    }
+
+    std::uint32_t pop()
+    {
+        auto const i = done_.back();
+        done_.pop_back();
+        return i;
+    }
+
+    // Called for each node after its children, whose indices are then on top of done_.
+    void write(Ast const& x)
+    {
+        if (ast_cast<Lazy>(x)) {
+            // The parsed body was written as the only child.
+        } else if (auto const* s = ast_cast<Syntax>(x)) {
+            done_.push_back(list(Node_kind::syntax, s->productions.size()));
+        } else if (ast_cast<Production>(x)) {
+            auto const ex = pop();
+            auto const id = pop();
+            done_.push_back(node(Node_kind::production, 0, id, ex));
+        } else if (auto const* e = ast_cast<Expression>(x)) {
+            done_.push_back(list(Node_kind::expression, 1 + e->terms.size()));
+        } else if (auto const* t = ast_cast<Term>(x)) {
+            done_.push_back(list(Node_kind::term, 1 + t->factors.size()));
+        } else if (auto const* f = ast_cast<Factor>(x)) {
+            done_.push_back(node(Node_kind::factor, static_cast<std::uint8_t>(f->type), pop(), 0));
+        } else if (auto const* l = ast_cast<Literal>(x)) {
+            done_.push_back(string(Node_kind::literal, l->value));
+        } else if (auto const* i = ast_cast<Identifier>(x)) {
+            done_.push_back(string(Node_kind::identifier, i->value));
+        } else if (auto const* c = ast_cast<Character>(x)) {
+            done_.push_back(node(Node_kind::character, 0, static_cast<unsigned char>(c->value), 0));
+        } else {
+            failed_ = true;
+        }
+    }
+
+public:
+
+    std::optional<std::uint32_t> write_tree(Ast const& root)
+    {
+        traverse(
+            root,
+            [this](Ast const&){ return !failed_; },
+            [this](Ast const& x){ if (!failed_) write(x); }
+        );
+        if (failed_) return {};
+        return done_.back();
+    }
+
+    std::string finish(std::uint32_t root, Ast_source const& source) const
+    {
+        std::string out;
+        out.reserve(header_size + nodes_.size() + 4 * children_.size() + pool_.size() + source.text.size());
+        out += magic;
+        put(out, ast_format_version, 2);
+        put(out, node_size, 2);
+        put(out, count_, 4);
+        put(out, children_.size(), 4);
+        put(out, pool_.size(), 4);
+        put(out, root, 4);
+        put(out, source.hash, 8);
+        put(out, source.text.size(), 8);
+        put(out, source.consumed, 8);
+        out += nodes_;
+        for (auto const i : children_) put(out, i, 4);
+        out += pool_;
+        out += source.text;
+        return out;
+    }
+};
+
+class Reader
+{
+    char const* nodes_;
+    char const* children_;
+    std::string_view pool_;
+    std::uint32_t child_count_;
+    std::vector<Ast> built_;
+
+    std::optional<std::vector<Ast>> list(std::uint32_t offset, std::uint32_t count) const
+    {
+        if (std::uint64_t{offset} + count > child_count_) return {};
+        std::vector<Ast> xs;
+        xs.reserve(count);
+        for (std::uint32_t i = 0; i != count; ++i) {
+            auto const index = get(children_ + 4 * (std::size_t{offset} + i), 4);
+            if (index >= built_.size()) return {};
+            xs.push_back(built_[index]);
+        }
+        return xs;
+    }
+
+    std::optional<std::string> string(std::uint32_t offset, std::uint32_t size) const
+    {
+        if (std::uint64_t{offset} + size > pool_.size()) return {};
+        return std::string{pool_.substr(offset, size)};
+    }
+
+    std::optional<Ast> node(char const* record) const
+    {
+        auto const kind = static_cast<Node_kind>(get(record, 1));
+        auto const sub = static_cast<std::uint8_t>(get(record + 1, 1));
+        auto const a = static_cast<std::uint32_t>(get(record + 4, 4));
+        auto const b = static_cast<std::uint32_t>(get(record + 8, 4));
+        switch (kind) {
+            case Node_kind::syntax:
+                if (auto xs = list(a, b)) return Ast{Syntax{std::move(*xs)}};
+                break;
+            case Node_kind::production:
+                if (a < built_.size() && b < built_.size()) return Ast{Production{built_[a], built_[b]}};
+                break;
+            case Node_kind::expression:
+                if (auto xs = list(a, b); xs && !xs->empty()) {
+                    auto te = xs->front();
+                    xs->erase(xs->begin());
+                    return Ast{Expression{std::move(te), std::move(*xs)}};
+                }
+                break;
+            case Node_kind::term:
+                if (auto xs = list(a, b); xs && !xs->empty()) {
+                    auto fa = xs->front();
+                    xs->erase(xs->begin());
+                    return Ast{Term{std::move(fa), std::move(*xs)}};
+                }
+                break;
+            case Node_kind::factor:
+                if (a < built_.size() && sub <= static_cast<std::uint8_t>(Factor::Type::id_v)) {
+                    return Ast{Factor{static_cast<Factor::Type>(sub), built_[a]}};
+                }
+                break;
+            case Node_kind::literal:
+                if (auto st = string(a, b)) return Ast{Literal{std::move(*st)}};
+                break;
+            case Node_kind::identifier:
+                if (auto st = string(a, b)) return Ast{Identifier{std::move(*st)}};
+                break;
+            case Node_kind::character:
+                if (a <= 0xff) return Ast{Character{static_cast<char>(a)}};
+                break;
+        }
+        return {};
+    }
+
+public:
+
+    Reader(char const* nodes, char const* children, std::uint32_t child_count, std::string_view pool)
+        : nodes_{nodes}, children_{children}, pool_{pool}, child_count_{child_count}
+    {}
+
+    std::optional<Ast> read(std::uint32_t node_count, std::uint32_t root)
+    {
+        built_.reserve(node_count);
+        for (std::uint32_t i = 0; i != node_count; ++i) {
+            if (auto x = node(nodes_ + node_size * i)) built_.push_back(std::move(*x)); else return {};
+        }
+        if (root >= built_.size()) return {};
+        return built_[root];
+    }
+};
+
+std::string hex(std::uint64_t value)
+{
+    constexpr std::string_view digits{"0123456789abcdef"};
+    std::string st(16, '0');
+    for (auto i = st.rbegin(); i != st.rend(); ++i, value >>= 4) {
+        *i = digits[value & 0xf];
+    }
+    return st;
+}
+
+}
+
+std::string serialize(Ast const& x, Ast_source const& source)
+{
+    Writer writer;
+    if (auto const root = writer.write_tree(x)) {
+        return writer.finish(*root, source);
+    } else {
+        return {};
+    }
+}
+
+std::optional<Ast> deserialize(std::string_view bytes, Ast_source* source)
+{
+    if (bytes.size() < header_size || !bytes.starts_with(magic)) return {};
+    auto const* in = bytes.data();
+    if (get(in + 4, 2) != ast_format_version || get(in + 6, 2) != node_size) return {};
+
+    auto const node_count = static_cast<std::uint32_t>(get(in + 8, 4));
+    auto const child_count = static_cast<std::uint32_t>(get(in + 12, 4));
+    auto const pool_size = static_cast<std::uint32_t>(get(in + 16, 4));
+    auto const root = static_cast<std::uint32_t>(get(in + 20, 4));
+    auto const children = header_size + node_size * node_count;
+    auto const pool = children + 4 * std::uint64_t{child_count};
+    auto const text_size = get(in + 32, 8);
+    if (pool + pool_size > bytes.size() || bytes.size() - pool - pool_size != text_size) return {};
+
+    if (source) {
+        *source = {get(in + 24, 8), std::string{bytes.substr(pool + pool_size)}, get(in + 40, 8)};
+    }
+    return Reader{in + header_size, in + children, child_count, bytes.substr(pool, pool_size)}
+        .read(node_count, root);
+}
+
+std::optional<Ast> load_ast(std::filesystem::path const& path, Ast_source* source)
+{
+#ifdef WIRTH_PARSER_POSIX
+    auto const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return {};
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return {};
+    }
+    auto const size = static_cast<std::size_t>(info.st_size);
+    auto* const data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return {};
+    auto result = deserialize({static_cast<char const*>(data), size}, source);
+    ::munmap(data, size);
+    return result;
+#else
+    std::ifstream file{path, std::ios::binary};
+    if (!file) return {};
+    std::string bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    return deserialize(bytes, source);
+#endif
+}
+
+bool save_ast(std::filesystem::path const& path, Ast const& x, Ast_source const& source)
+{
+    auto const bytes = serialize(x, source);
+    if (bytes.empty()) return false;
+
+    // Each writer has a file of its own, and the rename replaces the cache file
+    // in one step, so concurrent writers of the same file do not interleave.
+#ifdef WIRTH_PARSER_POSIX
+    auto temporary = path.string() + ".XXXXXX";
+    auto const fd = ::mkstemp(temporary.data());
+    if (fd < 0) return false;
+    // mkstemp() creates the file readable only by its owner. The cache file
+    // gets the permissions the umask gives a new file instead. The umask can
+    // only be read by setting it, and a file another thread creates meanwhile
+    // gets the stricter mask rather than a looser one.
+    auto const mask = ::umask(077);
+    ::umask(mask);
+    ::fchmod(fd, 0666 & ~mask);
+    auto const* p = bytes.data();
+    auto left = bytes.size();
+    while (left != 0) {
+        auto const written = ::write(fd, p, left);
+        if (written <= 0) break;
+        p += written;
+        left -= static_cast<std::size_t>(written);
+    }
+    if (::close(fd) != 0 || left != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+#else
+    auto temporary = path;
+    temporary += "." + hex(std::random_device{}()) + ".tmp";
+    {
+        std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+        if (!file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+            file.close();
+            std::error_code ignored;
+            std::filesystem::remove(temporary, ignored);
+            return false;
+        }
+    }
+#endif
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+    }
+    return !ec;
+}
+
+std::uint64_t content_hash(std::string_view input)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (auto const ch : input) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+auto cached_syntax(std::string_view input, std::filesystem::path const& directory) -> Parsed_t<Ast>
+{
+    auto const hash = content_hash(input);
+    auto const path = directory / (hex(hash) + ".wsna");
+
+    // The hash only names the file. The tree is used if the file holds the same source text.
+    Ast_source stored;
+    if (auto ast = load_ast(path, &stored)) {
+        if (stored.hash == hash && stored.text == input && stored.consumed <= input.size()) {
+            return {{std::move(*ast), input.substr(stored.consumed)}};
+        }
+    }
+
+    auto result = syntax(input);
+    if (result) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        save_ast(path, result->first, {hash, std::string{input}, input.size() - result->second.size()});
+    }
+    return result;
+}
@@ -0,0 +1,75 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "parser.h"
+#include "stream.h"
+
+Production_stream::Production_stream(Sink sink)
+    : sink_{std::move(sink)}
+{}
+
+bool Production_stream::feed(std::string_view chunk)
+{
+    if (failed_) return false;
+
+    buffer_ += chunk;
+    std::string::size_type start = 0;
+    for (auto i = scanned_; i != buffer_.size(); ++i) {
+        if (buffer_[i] == '"') {
+            in_literal_ = !in_literal_;
+        } else if (buffer_[i] == '.' && !in_literal_) {
+            auto const text = trivia(std::string_view{buffer_}.substr(start, i + 1 - start))->second;
+            if (auto result = try_parse(production)(text); result && result->second.empty()) {
+                sink_(std::move(result->first));
+            } else {
+                failed_ = true;
+                return false;
+            }
+            start = i + 1;
+        }
+    }
+    buffer_.erase(0, start);
+    scanned_ = buffer_.size();
+    return true;
+}
+
+bool Production_stream::finish()
+{
+    auto const blank = std::all_of(
+        buffer_.begin(), buffer_.end(), [](char ch){ return std::isspace(static_cast<unsigned char>(ch)); }
+    );
+    buffer_.clear();
+    scanned_ = 0;
+    in_literal_ = false;
+    return !failed_ && blank;
+}
@@ -0,0 +1,274 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WIRTH_PARSER_SSE2 1
+#endif
+
+#include "parser.h"
+#include "structural.h"
+#include "utf8.h"
+
+namespace {
+
+// Bit i of each mask is set if byte i of a block of 64 is in the class. Bytes
+// from 0x80 count as identifier bytes, and code points that are not letters or
+// digits are sorted out by indexed_lex().
+struct Block
+{
+    std::uint64_t quote;
+    std::uint64_t space;
+    std::uint64_t identifier;
+};
+
+#ifdef WIRTH_PARSER_SSE2
+
+// A mask of the bytes of v in the range [first, first + size).
+__m128i in_range(__m128i v, char first, char size)
+{
+    auto const offset = _mm_sub_epi8(v, _mm_set1_epi8(first));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(size - 1))), offset);
+}
+
+std::uint64_t bits(__m128i mask, int at)
+{
+    return static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(mask))) << at;
+}
+
+Block classify(unsigned char const* p)
+{
+    Block block{0, 0, 0};
+    for (int at = 0; at != 64; at += 16) {
+        auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + at));
+        block.quote |= bits(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), at);
+        block.space |= bits(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), in_range(v, '\t', 5)), at);
+        auto const letter = in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 26);
+        auto const digit = in_range(v, '0', 10);
+        auto const underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+        block.identifier |= bits(_mm_or_si128(_mm_or_si128(letter, digit), underscore), at) | bits(v, at);
+    }
+    return block;
+}
+
+#else
+
+enum : std::uint8_t { quote_class = 1, space_class = 2, identifier_class = 4 };
+
+constexpr auto classes = []{
+    std::array<std::uint8_t, 256> ret{};
+    ret['"'] = quote_class;
+    for (char x : std::string_view{" \t\n\v\f\r"}) ret[static_cast<unsigned char>(x)] = space_class;
+    for (std::size_t x = 0; x != 256; ++x) {
+        if ((x >= 'a' && x <= 'z') || (x >= 'A' && x <= 'Z') || (x >= '0' && x <= '9') || x == '_' || x >= 0x80) {
+            ret[x] = identifier_class;
+        }
+    }
+    return ret;
+}();
+
+Block classify(unsigned char const* p)
+{
+    Block block{0, 0, 0};
+    for (unsigned i = 0; i != 64; ++i) {
+        auto const x = classes[p[i]];
+        block.quote |= std::uint64_t{(x & quote_class) != 0} << i;
+        block.space |= std::uint64_t{(x & space_class) != 0} << i;
+        block.identifier |= std::uint64_t{(x & identifier_class) != 0} << i;
+    }
+    return block;
+}
+
+#endif
+
+// Bit i of the result is the parity of bits 0 to i of x.
+constexpr std::uint64_t prefix_xor(std::uint64_t x)
+{
+    for (int shift = 1; shift != 64; shift *= 2) x ^= x << shift;
+    return x;
+}
+
+constexpr bool is_ascii_identifier(char x)
+{
+    return (x >= 'a' && x <= 'z') || (x >= 'A' && x <= 'Z') || (x >= '0' && x <= '9') || x == '_';
+}
+
+// The identifier at the start of input, which starts with neither a digit nor
+// whitespace. ASCII is scanned inline, and anything else by identifier_span.
+auto identifier_at(std::string_view input) -> std::optional<std::string_view>
+{
+    std::size_t end = 0;
+    while (end != input.size() && is_ascii_identifier(input[end])) ++end;
+    if (end != input.size() && static_cast<unsigned char>(input[end]) >= 0x80) {
+        if (auto const id = identifier_span(input)) return id->first;
+        return {};
+    }
+    if (end == 0 || is_digit(static_cast<unsigned char>(input[0]))) return {};
+    return input.substr(0, end);
+}
+
+} // namespace
+
+auto structural_index(std::string_view input) -> std::vector<std::uint32_t>
+{
+    // Offsets are written eight at a time whatever the number of bits left,
+    // so there is always room for a whole block past the last one.
+    std::vector<std::uint32_t> index(input.size() / 4 + 64);
+    std::size_t size = 0;
+
+    auto const* const data = reinterpret_cast<unsigned char const*>(input.data());
+    std::uint64_t inside = 0;       // All ones if the last block ended inside a literal.
+    std::uint64_t last_quote = 0;   // Bit 0 set if the last block ended with a quote.
+    std::uint64_t last_identifier = 0;
+    for (std::size_t at = 0; at < input.size(); at += 64) {
+        // The last block is padded with spaces.
+        std::array<unsigned char, 64> tail;
+        auto const* block_data = data + at;
+        if (input.size() - at < 64) {
+            tail.fill(' ');
+            std::memcpy(tail.data(), block_data, input.size() - at);
+            block_data = tail.data();
+        }
+        auto const block = classify(block_data);
+        auto const next_quote = std::uint64_t{input.size() - at > 64 && input[at + 64] == '"'};
+
+        // A quote is an opening one if the bytes after it are inside a literal,
+        // and one that follows or precedes another quote is a doubled quote.
+        auto const in_literal = prefix_xor(block.quote) ^ inside;
+        auto const opening = block.quote & in_literal;
+        auto const closing = block.quote & ~in_literal;
+        auto const starts = opening & ~(block.quote << 1 | last_quote);
+        auto const ends = closing & ~(block.quote >> 1 | next_quote << 63);
+        auto const outside = ~in_literal & ~block.quote;
+        auto const continued = block.identifier & (block.identifier << 1 | last_identifier);
+        auto mask = starts | ends | (outside & ~block.space & ~continued);
+
+        inside = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_literal) >> 63);
+        last_quote = block.quote >> 63;
+        last_identifier = (block.identifier & outside) >> 63;
+
+        auto const count = static_cast<std::size_t>(std::popcount(mask));
+        if (index.size() < size + 64) index.resize(std::max(index.size() * 2, size + 64));
+        auto* out = index.data() + size;
+        for (auto const* end = out + count; out < end; out += 8) {
+            for (std::size_t i = 0; i != 8; ++i) {
+                out[i] = static_cast<std::uint32_t>(at + static_cast<std::size_t>(std::countr_zero(mask)));
+                mask &= mask - 1;
+            }
+        }
+        size += count;
+    }
+    index.resize(size);
+    return index;
+}
+
+auto indexed_lex(std::string_view input, std::span<std::uint32_t const> index) -> Parsed_t<std::vector<Token>>
+{
+    static constexpr std::string_view symbols{"=.|()[]{}"};
+    std::vector<Token> tokens;
+    tokens.reserve(index.size());
+    for (std::size_t i = 0; i != index.size(); ++i) {
+        count_step();
+        auto const at = index[i];
+        auto const rest = input.substr(at);
+        if (rest[0] == '"') {
+            // The next offset is the closing quote. Literals are not empty.
+            if (i + 1 == index.size() || index[i + 1] == at + 1) return {{std::move(tokens), rest}};
+            ++i;
+            tokens.push_back(Token{Token::Kind::literal, input.substr(at + 1, index[i] - at - 1)});
+        } else if (symbols.find(rest[0]) != std::string_view::npos) {
+            tokens.push_back(Token{Token::Kind::symbol, rest.substr(0, 1)});
+        } else if (auto const id = identifier_at(rest)) {
+            tokens.push_back(Token{Token::Kind::identifier, *id});
+            // A code point that is neither a letter nor a digit ends the
+            // identifier but was not indexed, and lex() stops at it.
+            if (id->size() != rest.size() && static_cast<unsigned char>(rest[id->size()]) >= 0x80) {
+                return {{std::move(tokens), rest.substr(id->size())}};
+            }
+        } else {
+            return {{std::move(tokens), rest}};
+        }
+    }
+    return {{std::move(tokens), input.substr(input.size())}};
+}
+
+auto indexed_syntax(std::string_view input) -> Parsed_t<Ast>
+{
+    if (!valid_utf8(input)) return {};
+    return lexed_syntax(input, indexed_lex(input, structural_index(input)));
+}
+
+auto parallel_syntax(std::string_view input, std::size_t threads) -> Parsed_t<Ast>
+{
+    if (!valid_utf8(input)) return {};
+    auto const tokens = indexed_lex(input, structural_index(input));
+    if (!tokens) return {};
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == 1 || !tokens->second.empty()) return lexed_syntax(input, tokens);
+
+    // Each chunk ends after the first "." at or past its share of the tokens.
+    Tokens const all{tokens->first};
+    std::vector<Tokens> chunks;
+    std::size_t begin = 0;
+    for (std::size_t k = 1; k <= threads && begin != all.size(); ++k) {
+        auto end = std::max(begin, all.size() * k / threads);
+        while (end != all.size() && (end == 0 || all[end - 1].kind != Token::Kind::symbol || all[end - 1].text != ".")) ++end;
+        chunks.push_back(all.subspan(begin, end - begin));
+        begin = end;
+    }
+
+    if (chunks.size() < 2) return lexed_syntax(input, tokens);
+
+    std::vector<Parsed_t<Ast, Tokens>> results(chunks.size());
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t k = 1; k < chunks.size(); ++k) {
+            workers.emplace_back([&chunks, &results, k]{ results[k] = token_syntax(chunks[k]); });
+        }
+        results[0] = token_syntax(chunks[0]);
+    }
+
+    std::vector<Ast> productions;
+    for (auto const& result : results) {
+        if (!result || !result->second.empty()) return lexed_syntax(input, tokens);
+        auto const& ps = ast_cast<Syntax>(result->first)->productions;
+        productions.insert(productions.end(), ps.begin(), ps.end());
+    }
+    return {{Ast{Syntax{std::move(productions)}}, tokens->second}};
+}
@@ -0,0 +1,217 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "parser.h"
+#include "tokens.h"
+
+namespace {
+
+constexpr Parser auto
+token_of(Token::Kind kind)
+{
+    return satisfy([kind](Token const& x){ return x.kind == kind; }, item_of<Tokens>);
+}
+
+constexpr Parser auto
+token_symbol(char ch)
+{
+    return satisfy([ch](Token const& x){ return x.kind == Token::Kind::symbol && x.text[0] == ch; }, item_of<Tokens>);
+}
+
+std::string unquoted(std::string_view text)
+{
+    std::string st;
+    for (std::size_t i = 0; i != text.size(); ++i) {
+        st += text[i];
+        if (text[i] == '"') ++i;
+    }
+    return st;
+}
+
+auto token_expression(Tokens input) -> Parsed_t<Ast, Tokens>;
+
+// factor = identifier | literal | "(" expression ")" | "[" expression "]" | "{" expression "}",
+// with the same commit points as syntax().
+auto token_factor(Tokens input) -> Parsed_t<Ast, Tokens>
+{
+    auto const bracketed = [](char open, char close, Factor::Type type)
+    {
+        return sequence(
+            [type](auto, auto ex, auto){ return Ast{Factor{type, std::move(ex)}}; },
+            token_symbol(open),
+            commit(token_expression),
+            commit(token_symbol(close))
+        );
+    };
+    static auto const parser =
+        choice(
+            sequence(
+                [](Token const& id){ return Ast{Factor{Factor::Type::id_v, Ast{Identifier{std::string{id.text}}}}}; },
+                token_of(Token::Kind::identifier)
+            ),
+            sequence(
+                [](Token const& li){ return Ast{Factor{Factor::Type::li_v, Ast{Literal{unquoted(li.text)}}}}; },
+                token_of(Token::Kind::literal)
+            ),
+            bracketed('(', ')', Factor::Type::gr_v),
+            bracketed('[', ']', Factor::Type::op_v),
+            bracketed('{', '}', Factor::Type::re_v),
+            // A quote mark that lex() read no literal from, where the literal
+            // of syntax() fails after it commits.
+            sequence(
+                [](auto, auto li){ return li; },
+                token_symbol('"'),
+                commit([](Tokens) -> Parsed_t<Ast, Tokens> { return {}; })
+            )
+        );
+    return parser(input);
+}
+
+// term = factor {factor}.
+auto token_term(Tokens input) -> Parsed_t<Ast, Tokens>
+{
+    static auto const parser =
+        sequence(
+            [](auto fa, auto fs){ return Ast{Term{std::move(fa), std::move(fs)}}; },
+            token_factor,
+            repeat(token_factor)
+        );
+    return parser(input);
+}
+
+// expression = term {"|" term}.
+auto token_expression(Tokens input) -> Parsed_t<Ast, Tokens>
+{
+    static auto const parser =
+        sequence(
+            [](auto te, auto ts){ return Ast{Expression{std::move(te), std::move(ts)}}; },
+            token_term,
+            repeat(
+                sequence(
+                    [](auto, auto te){ return te; },
+                    token_symbol('|'),
+                    token_term
+                )
+            )
+        );
+    return parser(input);
+}
+
+// production = identifier "=" expression ".".
+auto token_production(Tokens input) -> Parsed_t<Ast, Tokens>
+{
+    static auto const parser =
+        sequence(
+            [](Token const& id, auto, auto ex, auto){ return Ast{Production{Ast{Identifier{std::string{id.text}}}, std::move(ex)}}; },
+            token_of(Token::Kind::identifier),
+            token_symbol('='),
+            token_expression,
+            token_symbol('.')
+        );
+    return parser(input);
+}
+
+} // namespace
+
+auto lex(std::string_view input) -> Parsed_t<std::vector<Token>>
+{
+    static auto const parser =
+        sequence(
+            [](auto ts, auto){ return ts; },
+            repeat(
+                sequence(
+                    [](auto, Token x){ return x; },
+                    skip_whitespace,
+                    choice(
+                        sequence(
+                            [](std::string_view x){ return Token{Token::Kind::identifier, x}; },
+                            identifier_span
+                        ),
+                        sequence(
+                            [](auto, std::string_view x, auto){ return Token{Token::Kind::literal, x}; },
+                            symbol('"'),
+                            literal_span,
+                            symbol('"')
+                        ),
+                        sequence(
+                            [](std::string_view x){ return Token{Token::Kind::symbol, x}; },
+                            consumed(satisfy([](char x){ return std::string_view{"=.|()[]{}"}.find(x) != std::string_view::npos; }))
+                        )
+                    )
+                )
+            ),
+            skip_whitespace
+        );
+    return parser(input);
+}
+
+auto token_syntax(Tokens input) -> Parsed_t<Ast, Tokens>
+{
+    static auto const parser =
+        try_parse(
+            sequence(
+                [](auto ps){ return Ast{Syntax{std::move(ps)}}; },
+                repeat(token_production)
+            )
+        );
+    return parser(input);
+}
+
+auto lexed_syntax(std::string_view input) -> Parsed_t<Ast>
+{
+    if (!valid_utf8(input)) return {};
+    return lexed_syntax(input, lex(input));
+}
+
+auto lexed_syntax(std::string_view input, Parsed_t<std::vector<Token>> const& tokens) -> Parsed_t<Ast>
+{
+    if (!tokens) return {};
+    // A quote mark that lex() stopped at is passed on as a symbol, for
+    // token_factor() to fail on where syntax() would.
+    Tokens parsed = tokens->first;
+    std::vector<Token> quoted;
+    if (tokens->second.starts_with('"')) {
+        quoted = tokens->first;
+        quoted.push_back({Token::Kind::symbol, tokens->second.substr(0, 1)});
+        parsed = quoted;
+    }
+    auto result = token_syntax(parsed);
+    if (!result) return {};
+    if (result->second.empty()) {
+        return {{std::move(result->first), tokens->second}};
+    } else {
+        // The text of the first token that was not parsed, or its opening quote.
+        auto const& next = result->second.front();
+        auto const at = next.text.data() - (next.kind == Token::Kind::literal ? 1 : 0);
+        return {{std::move(result->first), input.substr(static_cast<std::size_t>(at - input.data()))}};
+    }
+}
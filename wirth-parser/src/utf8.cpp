@@ -0,0 +1,222 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WIRTH_PARSER_SSE2 1
+#endif
+
+#include "utf8.h"
+
+namespace {
+
+struct Range
+{
+    char32_t first;
+    char32_t last;
+};
+
+constexpr std::array letters{
+    // Latin-1 Supplement, Latin Extended-A and -B, IPA Extensions and Spacing Modifier Letters
+    Range{0x00aa, 0x00aa}, Range{0x00b5, 0x00b5}, Range{0x00ba, 0x00ba},
+    Range{0x00c0, 0x00d6}, Range{0x00d8, 0x00f6}, Range{0x00f8, 0x02c1},
+    // Greek and Coptic
+    Range{0x0370, 0x0374}, Range{0x0376, 0x0377}, Range{0x037b, 0x037d},
+    Range{0x0386, 0x0386}, Range{0x0388, 0x038a}, Range{0x038c, 0x038c},
+    Range{0x038e, 0x03a1}, Range{0x03a3, 0x03f5}, Range{0x03f7, 0x03ff},
+    // Cyrillic and Cyrillic Supplement
+    Range{0x0400, 0x0481}, Range{0x048a, 0x052f},
+    // Armenian
+    Range{0x0531, 0x0556}, Range{0x0561, 0x0587},
+    // Hebrew
+    Range{0x05d0, 0x05ea},
+    // Arabic
+    Range{0x0620, 0x064a}, Range{0x0671, 0x06d3},
+    // Devanagari
+    Range{0x0904, 0x0939},
+    // Thai
+    Range{0x0e01, 0x0e30},
+    // Georgian
+    Range{0x10a0, 0x10c5}, Range{0x10d0, 0x10fa},
+    // Hangul Jamo
+    Range{0x1100, 0x11ff},
+    // Ethiopic syllables up to the first gap in the block
+    Range{0x1200, 0x1248},
+    // Latin Extended Additional and Greek Extended
+    Range{0x1e00, 0x1fbc},
+    // Hiragana and Katakana
+    Range{0x3041, 0x3096}, Range{0x30a1, 0x30fa},
+    // CJK Unified Ideographs Extension A and CJK Unified Ideographs
+    Range{0x3400, 0x4dbf}, Range{0x4e00, 0x9fff},
+    // Hangul Syllables
+    Range{0xac00, 0xd7a3},
+    // Fullwidth Latin
+    Range{0xff21, 0xff3a}, Range{0xff41, 0xff5a},
+};
+
+// The letters of each case that are not in a range of alternating case below.
+constexpr std::array uppers{
+    Range{0x00c0, 0x00d6}, Range{0x00d8, 0x00de}, Range{0x0178, 0x0178},
+    Range{0x01f1, 0x01f1}, Range{0x01f6, 0x01f7}, Range{0x023a, 0x023b},
+    Range{0x023d, 0x023e}, Range{0x0241, 0x0241}, Range{0x0243, 0x0245},
+    Range{0x0386, 0x0386}, Range{0x0388, 0x038a}, Range{0x038c, 0x038c},
+    Range{0x038e, 0x038f}, Range{0x0391, 0x03a1}, Range{0x03a3, 0x03ab},
+    Range{0x0400, 0x042f}, Range{0x04c0, 0x04c0}, Range{0x0531, 0x0556},
+    Range{0x10a0, 0x10c5}, Range{0x1e9e, 0x1e9e}, Range{0xff21, 0xff3a},
+};
+
+constexpr std::array lowers{
+    Range{0x00b5, 0x00b5}, Range{0x00df, 0x00f6}, Range{0x00f8, 0x00ff},
+    Range{0x0138, 0x0138}, Range{0x0149, 0x0149}, Range{0x017f, 0x017f},
+    Range{0x01f0, 0x01f0}, Range{0x01f3, 0x01f3}, Range{0x0234, 0x0239},
+    Range{0x023c, 0x023c}, Range{0x023f, 0x0240}, Range{0x0242, 0x0242},
+    Range{0x0390, 0x0390}, Range{0x03ac, 0x03ce}, Range{0x0430, 0x045f}, Range{0x04cf, 0x04cf},
+    Range{0x0561, 0x0587}, Range{0x1e96, 0x1e9d}, Range{0x1e9f, 0x1e9f},
+    Range{0xff41, 0xff5a},
+};
+
+constexpr std::array digits{
+    Range{0x0660, 0x0669}, Range{0x06f0, 0x06f9}, Range{0x0966, 0x096f},
+    Range{0x0e50, 0x0e59}, Range{0xff10, 0xff19},
+};
+
+// Ranges where upper and lower case letters alternate, with the upper case
+// letter of each pair on a code point of the given parity.
+struct Alternating
+{
+    char32_t first;
+    char32_t last;
+    char32_t upper;
+};
+
+constexpr std::array alternating{
+    // Latin Extended-A: Ā ā to ķ, Ĺ ĺ to ň, Ŋ ŋ to ŷ and Ź ź to ž
+    Alternating{0x0100, 0x0137, 0}, Alternating{0x0139, 0x0148, 1},
+    Alternating{0x014a, 0x0177, 0}, Alternating{0x0179, 0x017e, 1},
+    // Latin Extended-B: Ǟ ǟ to ǯ, Ǵ ǵ, Ǹ ǹ to ȳ and Ɇ ɇ to ɏ
+    Alternating{0x01de, 0x01ef, 0}, Alternating{0x01f4, 0x01f5, 0},
+    Alternating{0x01f8, 0x0233, 0}, Alternating{0x0246, 0x024f, 0},
+    // Cyrillic: Ѡ ѡ to ҁ, Ҋ ҋ to ҿ, Ӂ ӂ to ӎ and Ӑ ӑ to ԯ
+    Alternating{0x0460, 0x0481, 0}, Alternating{0x048a, 0x04bf, 0},
+    Alternating{0x04c1, 0x04ce, 1}, Alternating{0x04d0, 0x052f, 0},
+    // Latin Extended Additional: Ḁ ḁ to ẕ and Ạ ạ to ỿ
+    Alternating{0x1e00, 0x1e95, 0}, Alternating{0x1ea0, 0x1eff, 0},
+};
+
+// Returns the range that contains x, if any.
+template <typename R, std::size_t N>
+R const* find(std::array<R, N> const& ranges, char32_t x)
+{
+    auto const i = std::upper_bound(
+        ranges.begin(), ranges.end(), x, [](char32_t y, R const& r){ return y < r.first; }
+    );
+    return i != ranges.begin() && x <= std::prev(i)->last ? &*std::prev(i) : nullptr;
+}
+
+template <std::size_t N>
+bool in(std::array<Range, N> const& ranges, char32_t x)
+{
+    return find(ranges, x) != nullptr;
+}
+
+// Whether x is an upper case letter, or a lower case one if lower, in a range of alternating case.
+bool alternating_case(char32_t x, bool lower)
+{
+    auto const range = find(alternating, x);
+    return range && x % 2 == (range->upper ^ char32_t{lower});
+}
+
+unsigned char const* skip_ascii(unsigned char const* p, unsigned char const* end)
+{
+#ifdef WIRTH_PARSER_SSE2
+    for (; end - p >= 16; p += 16) {
+        auto const mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)))
+        );
+        if (mask != 0) return p + std::countr_zero(mask);
+    }
+#else
+    for (; end - p >= 8; p += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof word);
+        if (word & 0x8080808080808080) break;
+    }
+#endif
+    while (p != end && *p < 0x80) ++p;
+    return p;
+}
+
+}
+
+bool valid_utf8(std::string_view input)
+{
+    auto const* p = reinterpret_cast<unsigned char const*>(input.data());
+    auto const* const end = p + input.size();
+    while ((p = skip_ascii(p, end)) != end) {
+        auto const lead = *p;
+        std::ptrdiff_t const size = lead >= 0xf5 ? 0 : lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc2 ? 2 : 0;
+        if (size == 0 || end - p < size) return false;
+
+        char32_t x = lead & (0x7f >> size);
+        for (std::ptrdiff_t i = 1; i != size; ++i) {
+            if ((p[i] & 0xc0) != 0x80) return false;
+            x = (x << 6) | (p[i] & 0x3f);
+        }
+        if ((size == 3 && x < 0x800) || (size == 4 && x < 0x10000)) return false;
+        if ((x >= 0xd800 && x <= 0xdfff) || x > 0x10ffff) return false;
+        p += size;
+    }
+    return true;
+}
+
+bool is_unicode_letter(char32_t x)
+{
+    return in(letters, x);
+}
+
+bool is_unicode_upper(char32_t x)
+{
+    return in(uppers, x) || alternating_case(x, false);
+}
+
+bool is_unicode_lower(char32_t x)
+{
+    return in(lowers, x) || alternating_case(x, true);
+}
+
+bool is_unicode_digit(char32_t x)
+{
+    return in(digits, x);
+}
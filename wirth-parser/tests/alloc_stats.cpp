@@ -0,0 +1,63 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <memory>
+#include <string_view>
+
+#include "alloc_stats.h"
+#include "check.h"
+
+namespace {
+
+Alloc_stats phase_stats(std::string_view phase)
+{
+    for (auto const& st : alloc_stats()) {
+        if (st.phase == phase) return st;
+    }
+    return {};
+}
+
+} // namespace
+
+// Only checks anything in a build with -DWIRTH_PARSER_ALLOC_STATS=ON.
+int main()
+{
+    if (!alloc_stats_enabled()) return failures();
+
+    auto block = [&]{ Alloc_phase phase{"test"}; return std::make_unique<char[]>(1000); }();
+    check(phase_stats("test").live >= 1000, "live bytes of an outstanding block");
+
+    // A reset while the block is outstanding, and then the block is freed.
+    alloc_stats_reset();
+    auto const after_reset = phase_stats("test");
+    check(after_reset.count == 0 && after_reset.bytes == 0, "reset clears the counts");
+    check(after_reset.live >= 1000 && after_reset.peak == after_reset.live, "reset keeps live bytes");
+    block.reset();
+    check(phase_stats("test").live >= 0, "live bytes stay non-negative");
+    check(phase_stats("test").peak == after_reset.peak, "peak since the reset");
+    return failures();
+}
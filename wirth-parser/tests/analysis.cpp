@@ -0,0 +1,118 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include "analysis.h"
+#include "check.h"
+#include "parser.h"
+
+/*
+analyze() over the grammars of the benchmark corpus that backtrack without
+bound and that are linear, and over small grammars with the errors that make
+a parser loop forever.
+*/
+
+namespace {
+
+std::string corpus(std::string_view name)
+{
+    std::ifstream in{std::string{WIRTH_PARSER_CORPUS} + "/" + std::string{name}, std::ios::binary};
+    return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+Grammar_analysis analysis(std::string_view grammar, std::set<std::string, std::less<>> const& lexical = {})
+{
+    auto const parsed = syntax(grammar);
+    return parsed && parsed->second.empty() ? analyze(parsed->first, lexical) : Grammar_analysis{};
+}
+
+Production_analysis const* production(Grammar_analysis const& x, std::string_view name)
+{
+    auto const found = std::ranges::find(x.productions, name, &Production_analysis::name);
+    return found != x.productions.end() ? &*found : nullptr;
+}
+
+bool has(Grammar_analysis const& x, Grammar_problem::Kind kind, std::string_view name)
+{
+    return std::ranges::any_of(x.problems, [&](auto const& p){ return p.kind == kind && p.production == name; });
+}
+
+} // namespace
+
+int main()
+{
+    using enum Grammar_problem::Kind;
+
+    auto const backtrack = analysis(corpus("backtrack.wsn"));
+    auto const* a = production(backtrack, "a");
+    auto const* b = production(backtrack, "b");
+    check(a && b, "backtrack productions");
+    if (a && b) {
+        check(a->first == "(z" && a->follow == ")" && !a->nullable, "FIRST and FOLLOW of a");
+        check(b->first == "(z" && b->follow == "xy" && !b->nullable, "FIRST and FOLLOW of b");
+        check(!a->backtracking_depth && !b->backtracking_depth, "unbounded depth of the productions");
+    }
+    check(has(backtrack, alternative_conflict, "a"), "conflict between the alternatives of a");
+    check(has(backtrack, unbounded_backtracking, "a"), "unbounded backtracking through a and b");
+    check(!backtrack.max_backtracking_depth && !backtrack.linear(), "backtrack is not linear");
+
+    auto const expr = analysis(corpus("expr.wsn"), {"identifier", "number"});
+    auto const* program = production(expr, "program");
+    auto const* expression = production(expr, "expression");
+    auto const* primary = production(expr, "primary");
+    auto const* number = production(expr, "number");
+    check(program && expression && primary && number, "expr productions");
+    if (program && expression && primary && number) {
+        check(program->nullable && !expression->nullable, "nullable productions");
+        check(expression->follow == "),;", "FOLLOW of expression");
+        check(number->first == "0-9" && primary->first == "(0-9A-Z_a-z", "FIRST of number and primary");
+        check(primary->backtracking_depth == 1 && number->backtracking_depth == 0, "backtracking depth of the productions");
+    }
+    check(has(expr, alternative_conflict, "primary"), "call and identifier conflict");
+    check(expr.problems.size() == 1, "expr has no other problems");
+    check(expr.max_backtracking_depth == 1 && expr.linear(), "expr is linear");
+
+    auto const left = analysis("a = a \"x\" | \"y\".");
+    check(has(left, left_recursion, "a") && !left.linear(), "left recursion");
+    check(production(left, "a") && production(left, "a")->left_recursive, "left recursive production");
+    auto const indirect = analysis("a = b \"x\" | \"y\". b = [\"z\"] a.");
+    check(has(indirect, left_recursion, "a") || has(indirect, left_recursion, "b"), "left recursion through a nullable prefix");
+
+    auto const nullable = analysis("a = {[\"x\"]} \"y\".");
+    check(has(nullable, nullable_repetition, "a") && !nullable.linear(), "repetition of a nullable part");
+    auto const repeated = analysis("a = {\"x\"} \"y\".");
+    check(repeated.problems.empty() && repeated.linear(), "repetition of a part that is not nullable");
+
+    return failures();
+}
@@ -0,0 +1,120 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stop_token>
+#include <string_view>
+
+#include "check.h"
+#include "parsing.h"
+
+/*
+A bounded parse within another one runs out with the outer budget, whether its
+steps, its deadline or its stop token, and abandons the outer parse, while
+running out of its own budget only abandons itself.
+*/
+
+namespace {
+
+using Reason = Budget_exhausted::Reason;
+
+// A parse of a hundred thousand steps.
+auto work(std::string_view input) -> Parsed_t<int>
+{
+    for (int i = 0; i != 100000; ++i) count_step();
+    return {{0, input}};
+}
+
+struct Nested
+{
+    // Why the outer and the inner parse ran out, if they did, and the steps
+    // the outer one took.
+    std::optional<Reason> outer;
+    std::optional<Reason> inner;
+    std::uint64_t steps;
+};
+
+// Runs work() within an inner budget within an outer one.
+Nested nested(Parse_budget const& outer, Parse_budget const& inner)
+{
+    std::optional<Reason> inner_reason;
+    auto const parser = [&](std::string_view input) -> Parsed_t<int>
+    {
+        inner_reason = bounded_parse(work, input, inner).exhausted;
+        return work(input);
+    };
+    auto const result = bounded_parse(parser, std::string_view{"x"}, outer);
+    return {result.exhausted, inner_reason, result.steps};
+}
+
+Parse_budget past_deadline()
+{
+    Parse_budget budget;
+    budget.deadline = std::chrono::steady_clock::now() - std::chrono::seconds{1};
+    return budget;
+}
+
+} // namespace
+
+int main()
+{
+    auto const unbounded = Parse_budget{};
+
+    auto const steps = nested(Parse_budget{150000}, unbounded);
+    check(steps.outer == Reason::steps && steps.inner == std::nullopt, "outer steps run out after the inner parse");
+    auto const outer_steps = nested(Parse_budget{50000}, unbounded);
+    check(
+        outer_steps.outer == Reason::steps && outer_steps.inner == std::nullopt && outer_steps.steps <= 50001,
+        "outer steps run out in the inner parse"
+    );
+    auto const inner_steps = nested(unbounded, Parse_budget{50000});
+    check(!inner_steps.outer && inner_steps.inner == Reason::steps, "inner steps run out");
+
+    auto const outer_deadline = nested(past_deadline(), unbounded);
+    check(
+        outer_deadline.outer == Reason::deadline && outer_deadline.inner == std::nullopt && outer_deadline.steps < 100000,
+        "outer deadline in the inner parse"
+    );
+    auto const inner_deadline = nested(unbounded, past_deadline());
+    check(!inner_deadline.outer && inner_deadline.inner == Reason::deadline, "inner deadline");
+
+    std::stop_source source;
+    source.request_stop();
+    Parse_budget cancelled;
+    cancelled.stop = source.get_token();
+    auto const outer_stop = nested(cancelled, unbounded);
+    check(
+        outer_stop.outer == Reason::cancelled && outer_stop.inner == std::nullopt && outer_stop.steps < 100000,
+        "outer stop token in the inner parse"
+    );
+    auto const inner_stop = nested(unbounded, cancelled);
+    check(!inner_stop.outer && inner_stop.inner == Reason::cancelled, "inner stop token");
+
+    return failures();
+}
@@ -0,0 +1,100 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast.h"
+#include "check.h"
+#include "serialize.h"
+
+/*
+Trees nested 100000 levels deep, which overflow the default stack of any
+recursive walk, are traversed, formatted, serialized and destroyed.
+
+The generated code indents every group, so the text of a nest of groups grows
+with the square of its depth. fmt() is run on a chain of expressions and terms
+instead, which are not indented, so its text stays small while its walk is
+as deep.
+*/
+
+namespace {
+
+constexpr std::size_t depth = 100000;
+
+Ast leaf()
+{
+    return Ast{Factor{Factor::Type::id_v, Ast{Identifier{"x"}}}};
+}
+
+// (((x))), as a Syntax with one production.
+Ast groups()
+{
+    auto x = leaf();
+    for (std::size_t i = 0; i != depth; ++i) {
+        x = Ast{Factor{Factor::Type::gr_v, Ast{Expression{Ast{Term{std::move(x), {}}}, {}}}}};
+    }
+    return Ast{Syntax{{Ast{Production{Ast{Identifier{"a"}}, Ast{Expression{Ast{Term{std::move(x), {}}}, {}}}}}}}};
+}
+
+Ast chain()
+{
+    auto x = leaf();
+    for (std::size_t i = 0; i != depth; ++i) {
+        x = Ast{Expression{Ast{Term{std::move(x), {}}}, {}}};
+    }
+    return x;
+}
+
+std::size_t nodes(Ast const& x)
+{
+    std::size_t entered = 0, left = 0;
+    traverse(x, [&](Ast const&){ ++entered; }, [&](Ast const&){ ++left; });
+    return entered == left ? entered : 0;
+}
+
+} // namespace
+
+int main()
+{
+    {
+        auto const tree = groups();
+        check(nodes(tree) == 3 * depth + 7, "traverse a nest of groups");
+
+        auto const bytes = serialize(tree);
+        auto const loaded = deserialize(bytes);
+        check(loaded && nodes(*loaded) == 3 * depth + 7 && serialize(*loaded) == bytes, "serialize a nest of groups");
+    }
+    {
+        auto const tree = chain();
+        check(nodes(tree) == 2 * depth + 2, "traverse a chain");
+        check(fmt(tree, 0) == fmt(leaf(), 0), "fmt a chain");
+    }
+    return failures();
+}
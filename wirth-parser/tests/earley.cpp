@@ -0,0 +1,128 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.h"
+#include "earley.h"
+#include "parser.h"
+
+/*
+Right recursion, which Leo's optimization parses in linear time, is parsed,
+and its tree built, on inputs long enough to overflow the stack of a recursive
+walk down the chain. Ambiguous grammars get the tree that Earley_parser
+documents, and earley_syntax() agrees with syntax().
+*/
+
+namespace {
+
+// The productions of a tree, with the children of a node in parentheses.
+std::string shape(Parse_node const& x)
+{
+    if (x.children.empty()) return std::string{x.production};
+    auto ret = std::string{x.production} + "(";
+    for (auto const& child : x.children) ret += shape(child) + " ";
+    ret.back() = ')';
+    return ret;
+}
+
+// The number of nodes on the path down the last children of a tree.
+std::size_t depth(Parse_node const& x)
+{
+    std::size_t ret = 1;
+    for (auto const* y = &x; !y->children.empty(); y = &y->children.back()) ++ret;
+    return ret;
+}
+
+struct Parse
+{
+    bool complete = false;
+    std::size_t depth = 0;
+    std::uint64_t steps = 0;
+};
+
+// Parses a run of a's with a production of a grammar.
+Parse run(std::string_view grammar, std::string_view start, std::size_t length)
+{
+    Earley_parser const parser{syntax(grammar)->first, start};
+    auto const before = parse_steps;
+    auto const result = parser(std::string(length, 'a'));
+    return {result && result->second.empty(), result ? depth(result->first) : 0, parse_steps - before};
+}
+
+// Whether a right-recursive grammar parses runs of a's completely, with a
+// tree as deep as the run is long, in a number of steps linear in it.
+bool linear(std::string_view grammar, std::string_view start)
+{
+    constexpr std::size_t length = 20000;
+    auto const half = run(grammar, start, length / 2);
+    auto const full = run(grammar, start, length);
+    return half.complete && full.complete && full.depth >= length && full.steps <= 2 * half.steps + 16;
+}
+
+std::string shape_of(std::string_view grammar, std::string_view start, std::string_view input)
+{
+    Earley_parser const parser{syntax(grammar)->first, start};
+    auto const result = parser(input);
+    return result && result->second.empty() ? shape(result->first) : "no parse";
+}
+
+// Whether earley_syntax() parses a grammar to the tree that syntax() does.
+bool same_syntax(std::string_view grammar)
+{
+    auto const expected = syntax(grammar);
+    auto const actual = earley_syntax(grammar);
+    return expected && actual && actual->second == expected->second && fmt(actual->first, 0) == fmt(expected->first, 0);
+}
+
+} // namespace
+
+int main()
+{
+    check(linear("p = \"a\" p | \"a\".", "p"), "right recursion");
+    check(linear("s = p. p = \"a\" [p].", "s"), "right recursion through an optional");
+    check(linear("s = p. p = a [p]. a = \"a\".", "s"), "right recursion after a token");
+    check(linear("p = [\"a\" p].", "p"), "nullable right recursion");
+    check(run("p = [\"a\" p].", "p", 0).complete, "nullable right recursion on no input");
+
+    check(shape_of("e = e \"+\" e | x. x = \"x\".", "e", "x+x+x") == "e(e(e(x) e(x)) e(x))", "ambiguous sum");
+    check(shape_of("e = x \"+\" e | e \"+\" x | x. x = \"x\".", "e", "x+x+x") == "e(x e(x e(x)))", "earlier alternative");
+    check(shape_of("s = a \"b\" | \"a\" b. a = \"a\". b = \"b\".", "s", "ab") == "s(a)", "alternatives that match the same");
+    check(shape_of("p = [\"a\" p]. q = p p.", "q", "aa") == "q(p(p(p)) p)", "nullable parts match from the left");
+
+    check(same_syntax("a = b [\"c\"\"d\"] | {(e | f) g}.\nb = \"x\".\n"), "earley_syntax of a grammar");
+    check(same_syntax("a = \"\"\"\" b. b = {\"x\" | \"\"\"\"\"\"}."), "earley_syntax of quotes");
+    auto const nested = "a = " + std::string(5000, '(') + "x" + std::string(5000, ')') + ".";
+    auto const deep = earley_syntax(nested);
+    check(deep && deep->second.empty(), "earley_syntax of deep nesting");
+
+    return failures();
+}
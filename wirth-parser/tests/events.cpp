@@ -0,0 +1,86 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+#include "check.h"
+#include "events.h"
+#include "parser.h"
+
+namespace {
+
+// Whether parse_events() with an Ast_builder gives the same result as syntax().
+bool same_as_syntax(std::string_view input)
+{
+    auto const expected = syntax(input);
+    Ast_builder builder;
+    auto const events = parse_events(input, builder);
+    if (!expected || !events) return !expected && !events;
+    return expected->second == events->second && builder.result()
+        && fmt(expected->first, 0) == fmt(*builder.result(), 0);
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<std::string_view> const inputs{
+        "",
+        "a = b.",
+        "a = b. c = ",
+        "a = b | .",
+        "a = b | c d. e",
+        "a = b c",
+        "a = .",
+        "a = b. = c.",
+        "a = (b | \"c\"\"d\") [e] {f g}.",
+        "a = (b.",
+        "a = \"b.",
+        "a = \"\".",
+        "a = b | (c | .",
+        "a = b. c = d | e. f = g h | .",
+    };
+    for (auto const input : inputs) check(same_as_syntax(input), input);
+
+    // Random strings over the tokens of the grammar, with a fixed seed.
+    constexpr std::string_view atoms[] = {"a", "b", " ", "=", ".", "|", "(", ")", "[", "]", "{", "}", "\"", "\"x\""};
+    std::uint64_t state = 1;
+    for (int i = 0; i != 20000; ++i) {
+        std::string input;
+        for (auto n = 3 + i % 24; n != 0; --n) {
+            state = state * 6364136223846793005 + 1442695040888963407;
+            input += atoms[(state >> 33) % std::size(atoms)];
+        }
+        check(same_as_syntax(input), input);
+    }
+
+    return failures();
+}
@@ -0,0 +1,62 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <sstream>
+
+#include "check.h"
+#include "generator.h"
+#include "parser.h"
+
+namespace {
+
+bool generates(std::string_view grammar, std::string_view start)
+{
+    auto const parsed = syntax(grammar);
+    std::ostringstream out;
+    Generator_options options;
+    options.size = 1024;
+    return parsed && parsed->second.empty() && generate(parsed->first, start, options, out);
+}
+
+} // namespace
+
+int main()
+{
+    check(generates("s = \"x\" | s \"y\".", "s"), "left recursion with an exit");
+    check(generates("s = \"(\" [s] \")\" | letter.", "s"), "nesting through an option");
+
+    check(!generates("s = s \"y\".", "s"), "start without an exit");
+    check(!generates("s = \"x\" b.", "s"), "undefined identifier");
+    check(!generates("s = \"x\".", "t"), "undefined start");
+
+    // Start has a finite sentence, but may pick an alternative that never ends.
+    check(!generates("s = \"x\" | b.\nb = b \"y\".", "s"), "unbounded production reachable from start");
+    check(!generates("s = \"x\" [b].\nb = \"y\" b.", "s"), "unbounded production in an option");
+    check(generates("s = \"x\".\nb = b \"y\".", "s"), "unbounded production not reachable from start");
+
+    return failures();
+}
@@ -0,0 +1,87 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <string>
+#include <string_view>
+
+#include "check.h"
+#include "parsing.h"
+
+namespace {
+
+// Writes each fold out in parentheses, so the result shows the grouping.
+template <char... Op>
+std::string fold(std::string x, std::string y)
+{
+    return "(" + x + std::string{Op...} + y + ")";
+}
+
+constexpr Parser auto atom = sequence([](char x){ return std::string(1, x); }, letter);
+
+auto const expression = operators<decltype(atom)>(
+    {
+        {"<", 1, Associativity::left, fold<'<'>},
+        {"<<", 2, Associativity::left, fold<'<', '<'>},
+        {"+", 3, Associativity::left, fold<'+'>},
+        {"-", 3, Associativity::left, fold<'-'>},
+        {"*", 4, Associativity::left, fold<'*'>},
+        {"/", 4, Associativity::left, fold<'/'>},
+        {"^", 5, Associativity::right, fold<'^'>},
+    },
+    atom
+);
+
+// Whether the expression parses to the grouping given and leaves rest.
+bool parses(std::string_view input, std::string_view grouping, std::string_view rest = {})
+{
+    auto const result = expression(input);
+    return result && result->first == grouping && result->second == rest;
+}
+
+} // namespace
+
+int main()
+{
+    check(parses("a", "a"), "single atom");
+    check(parses("a-b-c", "((a-b)-c)"), "left associativity");
+    check(parses("a^b^c", "(a^(b^c))"), "right associativity");
+    check(parses("a^b^c^d", "(a^(b^(c^d)))"), "long right chain");
+    check(parses("a+b*c", "(a+(b*c))"), "higher precedence on the right");
+    check(parses("a*b+c", "((a*b)+c)"), "higher precedence on the left");
+    check(parses("a-b+c", "((a-b)+c)"), "equal precedence folds left");
+    check(parses("a/b*c", "((a/b)*c)"), "equal precedence folds left");
+    check(parses("a+b*c-d/e", "((a+(b*c))-(d/e))"), "mixed chain");
+    check(parses("a*b^c^d+e", "((a*(b^(c^d)))+e)"), "right associative inside left");
+    check(parses("a + b * c", "(a+(b*c))"), "whitespace around operators");
+    check(parses("a<<b<c", "((a<<b)<c)"), "longest operator first");
+    check(parses("a<b<<c", "(a<(b<<c))"), "longest operator first");
+    check(parses("a+b+", "(a+b)", "+"), "trailing operator is left in the input");
+    check(parses("a+b 1", "(a+b)", " 1"), "operator without an atom is left in the input");
+    check(!expression(""), "no atom");
+    check(!expression("+a"), "leading operator");
+    return failures();
+}
@@ -0,0 +1,77 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <string_view>
+
+#include "ast.h"
+#include "check.h"
+#include "parser.h"
+#include "tokens.h"
+
+namespace {
+
+// Whether a production fails on input without throwing.
+template <typename F>
+bool fails(F production, std::string_view input)
+{
+    try {
+        return !production(input);
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace
+
+int main()
+{
+    // Each of these fails after a commit.
+    check(fails(factor, "(x"), "factor with an unclosed group");
+    check(fails(factor, "[x"), "factor with an unclosed option");
+    check(fails(factor, "{x"), "factor with an unclosed repetition");
+    check(fails(factor, "\"x"), "factor with an unclosed literal");
+    check(fails(literal, "\"x"), "unclosed literal");
+    check(fails(literal, "\"\""), "empty literal");
+    check(fails(term, "(x"), "term with an unclosed group");
+    check(fails(expression, "a | (x"), "expression with an unclosed group");
+    check(fails(production, "a = (x."), "production with an unclosed group");
+
+    check(factor("(x) y") && factor("(x) y")->second == "y", "factor with a group");
+    check(production("a = b | \"c\". d") && production("a = b | \"c\". d")->second == "d", "production");
+
+    // syntax() still fails as a whole after a commit instead of stopping early.
+    check(!syntax("a = b. c = (d."), "syntax with an unclosed group");
+    check(syntax("a = b. c = d") && syntax("a = b. c = d")->second == "c = d", "syntax with an unfinished production");
+
+    // lexed_syntax() commits where syntax() does.
+    check(!lexed_syntax("a = b. c = (x ."), "lexed_syntax with an unclosed group");
+    check(!lexed_syntax("a = (b | ) ."), "lexed_syntax with an empty term");
+    check(!lexed_syntax("a = b. c = \"\" ."), "lexed_syntax with an empty literal");
+    check(lexed_syntax("a = b. \"c") && lexed_syntax("a = b. \"c")->second == "\"c", "lexed_syntax stopping at a quote mark");
+
+    return failures();
+}
@@ -0,0 +1,84 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ast.h"
+#include "check.h"
+#include "parser.h"
+#include "serialize.h"
+
+int main()
+{
+    auto const directory = std::filesystem::temp_directory_path() / "wirth-parser-test-serialize";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::string const a = "a = \"x\" b.\nb = {\"y\"}.\n";
+    std::string const b = "c = \"z\".\n";
+    auto const tree_a = syntax(a);
+    auto const tree_b = syntax(b);
+    check(tree_a && tree_b, "grammars parse");
+    if (!tree_a || !tree_b) return failures();
+
+    auto const round_trip = deserialize(serialize(tree_a->first));
+    check(round_trip && fmt(*round_trip, 0) == fmt(tree_a->first, 0), "round trip");
+
+    // The cache file of b holds the tree of a, as if their hashes collided.
+    char name[32];
+    std::snprintf(name, sizeof name, "%016llx.wsna", static_cast<unsigned long long>(content_hash(b)));
+    auto const path = directory / name;
+    check(save_ast(path, tree_a->first, {content_hash(b), a, a.size()}), "save");
+    Ast_source stored;
+    auto const loaded = load_ast(path, &stored);
+    check(loaded && stored.text == a && stored.consumed == a.size(), "load with source");
+
+    auto const cached = cached_syntax(b, directory);
+    check(cached && fmt(cached->first, 0) == fmt(tree_b->first, 0), "cache parses a new grammar");
+    auto const again = cached_syntax(b, directory);
+    check(again && fmt(again->first, 0) == fmt(tree_b->first, 0), "cache hit");
+
+    // Writers of the same file each write a whole file of their own.
+    auto const shared = directory / "shared.wsna";
+    std::vector<std::thread> writers;
+    for (int i = 0; i != 8; ++i) {
+        writers.emplace_back([&, i]{ save_ast(shared, (i % 2 ? tree_a : tree_b)->first); });
+    }
+    for (auto& t : writers) t.join();
+    auto const last = load_ast(shared);
+    check(last.has_value(), "concurrent writers leave a whole file");
+    std::size_t files = 0;
+    for ([[maybe_unused]] auto const& entry : std::filesystem::directory_iterator{directory}) ++files;
+    check(files == 2, "no temporary files are left");
+
+    std::filesystem::remove_all(directory);
+    return failures();
+}
@@ -0,0 +1,127 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <cstddef>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "check.h"
+#include "earley.h"
+#include "generator.h"
+#include "parser.h"
+#include "structural.h"
+#include "tokens.h"
+
+/*
+indexed_lex() returns the tokens and remainder of lex(), and indexed_syntax()
+and parallel_syntax() the result of syntax(), on grammars that parse, that
+fail after a commit and that stop early, and on short strings of the bytes
+grammars are made of.
+*/
+
+namespace {
+
+bool same_lex(std::string_view input)
+{
+    auto const expected = lex(input);
+    auto const actual = indexed_lex(input, structural_index(input));
+    if (!expected || !actual) return !expected && !actual;
+    if (actual->second != expected->second || actual->first.size() != expected->first.size()) return false;
+    for (std::size_t i = 0; i != expected->first.size(); ++i) {
+        auto const& x = expected->first[i];
+        auto const& y = actual->first[i];
+        if (x.kind != y.kind || x.text != y.text) return false;
+    }
+    return true;
+}
+
+bool same_tree(Parsed_t<Ast> const& expected, Parsed_t<Ast> const& actual)
+{
+    if (!expected || !actual) return !expected && !actual;
+    return actual->second == expected->second && fmt(actual->first, 0) == fmt(expected->first, 0);
+}
+
+// Whether each way of parsing a grammar agrees with syntax().
+bool same_syntax(std::string_view input)
+{
+    auto const expected = syntax(input);
+    return same_lex(input)
+        && same_tree(expected, lexed_syntax(input))
+        && same_tree(expected, indexed_syntax(input))
+        && same_tree(expected, parallel_syntax(input, 1))
+        && same_tree(expected, parallel_syntax(input, 4));
+}
+
+// A grammar of many productions, which parallel_syntax() splits.
+std::string generated()
+{
+    std::ostringstream out;
+    Generator_options options;
+    options.seed = 1;
+    options.size = 16384;
+    options.lexical = {"identifier", "literal"};
+    generate(syntax(earley_self_grammar)->first, "syntax", options, out);
+    return out.str();
+}
+
+} // namespace
+
+int main()
+{
+    check(same_syntax("a = b [\"c\"\"d\"] | {(e | f) g}.\nb = \"x\"."), "grammar");
+    check(same_syntax("größe = \"ä\" | wert.\nwert = \"1\"."), "identifiers and literals outside ASCII");
+    check(same_syntax("a = b€c."), "a code point that stops an identifier");
+    check(same_syntax(""), "no input");
+    check(same_syntax("a = b. c = (x ."), "unclosed group");
+    check(same_syntax("a = (b | ) ."), "empty term");
+    check(same_syntax("a = b. c = \"\" ."), "empty literal");
+    check(same_syntax("a = b. c = \"x"), "unclosed literal");
+    check(same_syntax("a = b. \"c\""), "literal where a production starts");
+    check(same_syntax("a = b. c = d"), "unfinished production");
+    check(same_syntax("a = b. # c = d."), "byte that starts no token");
+
+    auto const grammar = generated();
+    auto const parsed = syntax(grammar);
+    check(parsed && parsed->second.empty() && grammar.size() > 8192, "generated grammar parses");
+    check(same_syntax(grammar), "generated grammar");
+    check(same_syntax(grammar + "a = (b ."), "generated grammar ending in an unclosed group");
+    check(same_syntax("a = (b .\n" + grammar), "generated grammar after an unclosed group");
+
+    std::mt19937 random{1};
+    constexpr std::string_view bytes = "ab=.|()[]{}\" \n";
+    bool all_same = true;
+    for (int i = 0; i != 20000; ++i) {
+        std::string input(random() % 24, ' ');
+        for (auto& x : input) x = bytes[random() % bytes.size()];
+        all_same = all_same && same_syntax(input);
+    }
+    check(all_same, "random strings");
+
+    return failures();
+}
@@ -0,0 +1,84 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <string_view>
+
+#include "check.h"
+#include "utf8.h"
+
+int main()
+{
+    check(valid_utf8("abc \u00e5\u00e4\u00f6 \u4e2d \U0001f600"), "well-formed");
+    check(!valid_utf8("\x80"), "stray continuation byte");
+    check(!valid_utf8("\xc0\xaf"), "overlong encoding");
+    check(!valid_utf8("\xed\xa0\x80"), "surrogate");
+    check(!valid_utf8("\xf4\x90\x80\x80"), "above U+10FFFF");
+    check(!valid_utf8("\xe4\xb8"), "truncated sequence");
+
+    // Pairs of an upper case letter and its lower case letter.
+    constexpr char32_t pairs[][2] = {
+        {U'A', U'a'}, {U'\u00c5', U'\u00e5'}, {U'\u0100', U'\u0101'}, {U'\u0136', U'\u0137'},
+        {U'\u0139', U'\u013a'}, {U'\u0147', U'\u0148'}, {U'\u014a', U'\u014b'}, {U'\u0176', U'\u0177'},
+        {U'\u0179', U'\u017a'}, {U'\u017d', U'\u017e'}, {U'\u01de', U'\u01df'}, {U'\u01f4', U'\u01f5'},
+        {U'\u0220', U'\u0221'}, {U'\u0246', U'\u0247'}, {U'\u0391', U'\u03b1'}, {U'\u0416', U'\u0436'},
+        {U'\u0460', U'\u0461'}, {U'\u048a', U'\u048b'}, {U'\u04c1', U'\u04c2'}, {U'\u04cd', U'\u04ce'},
+        {U'\u04d0', U'\u04d1'}, {U'\u052e', U'\u052f'}, {U'\u1e00', U'\u1e01'}, {U'\u1ea0', U'\u1ea1'},
+    };
+    for (auto const& [up, low] : pairs) {
+        check(is_upper(up) && !is_lower(up), "upper case");
+        check(is_lower(low) && !is_upper(low), "lower case");
+        check(is_letter(up) && is_letter(low), "letters");
+    }
+
+    // Letters inside or next to the alternating ranges whose case does not alternate.
+    for (char32_t x : {U'\u0178', U'\u01f1', U'\u01f7', U'\u0243', U'\u04c0', U'\u1e9e'}) {
+        check(is_upper(x) && !is_lower(x), "upper case outside a pair");
+    }
+    for (char32_t x : {U'\u0138', U'\u0149', U'\u017f', U'\u01f0', U'\u0234', U'\u04cf', U'\u1e96'}) {
+        check(is_lower(x) && !is_upper(x), "lower case outside a pair");
+    }
+    check(!is_upper(U'\u01f2') && !is_lower(U'\u01f2'), "title case");
+
+    for (char32_t x : {U'\u0386', U'\u0388', U'\u038a', U'\u038c', U'\u038e', U'\u038f'}) {
+        check(is_letter(x) && is_upper(x) && !is_lower(x), "accented Greek capital");
+    }
+    check(is_letter(U'\u0390') && is_lower(U'\u0390'), "accented Greek small letter");
+    for (char32_t x : {U'\u0387', U'\u038b', U'\u038d', U'\u03a2', U'\u03f6'}) {
+        check(!is_letter(x), "not a Greek letter");
+    }
+    check(is_letter(U'\u03f5') && is_letter(U'\u03f7'), "Greek letters around a symbol");
+
+    check(is_letter(U'\u1100') && is_letter(U'\u11ff'), "Hangul Jamo");
+    check(is_letter(U'\u1200') && is_letter(U'\u1248'), "Ethiopic");
+    check(!is_letter(U'\u1249'), "gap in Ethiopic");
+    check(is_letter(U'\uac00') && !is_upper(U'\uac00') && !is_lower(U'\uac00'), "caseless letter");
+    check(is_digit(U'\u0663') && !is_letter(U'\u0663'), "Arabic-Indic digit");
+
+    auto const id = many(u_letter)("\u0141\u00f3d\u017a 1");
+    check(id && id->first == "\u0141\u00f3d\u017a" && id->second == " 1", "code point letters");
+    return failures();
+}